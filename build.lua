@@ -2,7 +2,35 @@ tool 'tools-gfx' {
    app 'atex' {
       icon 'icon/bengine-warm.ico',
       limp_src 'src-atex/*.hpp',
-      src 'src-atex/*.cpp',
+      src {
+         'src-atex/*.cpp',
+         'src-common/*.cpp'
+      },
+      link_project {
+         'core',
+         'core-id-with-names',
+         'util',
+         'util-fs',
+         'util-string',
+         'cli',
+         'gfx-tex',
+         'gfx'
+      }
+   },
+   app 'atex-bench' {
+      icon 'icon/bengine-warm.ico',
+      limp_src 'src-atex-bench/*.hpp',
+      src {
+         'src-atex-bench/*.cpp',
+         'src-atex/atex_app*.cpp',
+         'src-atex/blit_kernels.cpp',
+         'src-atex/block_*.cpp',
+         'src-atex/content_hash.cpp',
+         'src-atex/dds_writer.cpp',
+         'src-atex/mipmap_generator.cpp',
+         'src-atex/profiler.cpp',
+         'src-common/*.cpp'
+      },
       link_project {
          'core',
          'core-id-with-names',
@@ -17,7 +45,10 @@ tool 'tools-gfx' {
    app 'concur' {
       icon 'icon/bengine-warm.ico',
       limp_src 'src-concur/*.hpp',
-      src 'src-concur/*.cpp',
+      src {
+         'src-concur/*.cpp',
+         'src-common/*.cpp'
+      },
       link_project {
          'core',
          'core-id-with-names',
@@ -0,0 +1,7 @@
+#include "atex_bench_app.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) {
+   be::atex::AtexBenchApp app(argc, argv);
+   return app();
+}
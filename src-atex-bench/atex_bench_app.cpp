@@ -0,0 +1,883 @@
+#include "atex_bench_app.hpp"
+#include "version.hpp"
+#include "../src-atex/atex_app.hpp"
+#include "../src-atex/blit_kernels.hpp"
+#include "../src-atex/block_codec.hpp"
+#include "../src-atex/block_decoder.hpp"
+#include "../src-atex/dds_writer.hpp"
+#include "../src-atex/version.hpp"
+#include <be/gfx/version.hpp>
+#include <be/core/version.hpp>
+#include <be/core/log_exception.hpp>
+#include <be/core/logging.hpp>
+#include <be/cli/cli.hpp>
+#include <be/gfx/tex/visit_texture.hpp>
+#include <be/gfx/tex/texture_reader.hpp>
+#include <be/gfx/tex/mipmapping.hpp>
+#include <be/gfx/tex/blit_pixels.hpp>
+#include <be/gfx/tex/betx_writer.hpp>
+#include <be/gfx/tex/ktx_writer.hpp>
+#include <be/gfx/tex/bmp_writer.hpp>
+#include <be/gfx/tex/hdr_writer.hpp>
+#include <be/gfx/tex/jpeg_writer.hpp>
+#include <be/gfx/tex/png_writer.hpp>
+#include <be/gfx/tex/tga_writer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+namespace be::atex {
+namespace {
+
+using namespace gfx::tex;
+
+///////////////////////////////////////////////////////////////////////////////
+ImageFormat rgba8_format(Colorspace colorspace) {
+   ImageFormat format;
+   format.packing(BlockPacking::s_8_8_8_8);
+   format.block_dim(ImageFormat::block_dim_type(1));
+   format.block_size(4);
+   format.components(4);
+   format.field_types(ImageFormat::field_types_type(FieldType::unorm));
+   format.swizzles(swizzles_rgba());
+   format.colorspace(colorspace);
+   format.premultiplied(false);
+   return format;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ImageFormat bgra8_format(Colorspace colorspace) {
+   ImageFormat format = rgba8_format(colorspace);
+   format.swizzles(ImageFormat::swizzles_type(Swizzle::field_two, Swizzle::field_one, Swizzle::field_zero, Swizzle::field_three));
+   return format;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ImageFormat rgba32f_format() {
+   ImageFormat format = rgba8_format(Colorspace::linear_srgb);
+   format.packing(BlockPacking::s_32_32_32_32);
+   format.block_size(16);
+   format.field_types(ImageFormat::field_types_type(FieldType::sfloat));
+   return format;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ImageFormat block_format(BlockPacking packing) {
+   ImageFormat format = rgba8_format(Colorspace::srgb);
+   format.packing(packing);
+   format.block_dim(ImageFormat::block_dim_type(4, 4, 1));
+   format.block_size(ImageFormat::block_size_type(block_codec_size(block_codec(format))));
+   return format;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Texture make_texture(const ImageFormat& format, TextureClass tex_class, std::size_t layers, std::size_t faces, std::size_t levels, ivec3 dim) {
+   Texture result;
+   result.storage = std::make_unique<TextureStorage>(layers, faces, levels, dim, format.block_dim(), format.block_size(), TextureAlignment());
+   result.view = TextureView(format, tex_class, *result.storage, 0, layers, 0, faces, 0, levels);
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Smooth gradients plus a little noise, so that neither the block encoders
+// nor the PNG/zlib compressors see trivially compressible data.
+void fill_texture(const TextureView& view, bool hdr) {
+   visit_texture_images(view, [&](const ImageView& img) {
+      ivec3 dim = img.dim();
+      U32 seed = U32(img.layer() * 7919 + img.face() * 104729 + img.level() * 15485863);
+      UC* data = static_cast<UC*>(img.data());
+      for (I32 y = 0; y < dim.y; ++y) {
+         UC* line = data + y * img.line_span();
+         for (I32 x = 0; x < dim.x; ++x) {
+            U32 noise = (U32(x) * 73856093u) ^ (U32(y) * 19349663u) ^ seed;
+            noise = (noise ^ (noise >> 13)) * 0x5bd1e995u;
+            noise ^= noise >> 15;
+
+            F32 u = F32(x) / F32(std::max(1, dim.x - 1));
+            F32 v = F32(y) / F32(std::max(1, dim.y - 1));
+            F32 texel[4] = {
+               u,
+               v,
+               0.5f + 0.25f * F32(noise & 0xFF) / 255.f,
+               (u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f) < 0.2f ? 1.f : 0.25f
+            };
+
+            if (hdr) {
+               F32* p = reinterpret_cast<F32*>(line) + 4 * x;
+               for (std::size_t c = 0; c < 3; ++c) {
+                  p[c] = texel[c] * 4.f;
+               }
+               p[3] = texel[3];
+            } else {
+               UC* p = line + 4 * x;
+               for (std::size_t c = 0; c < 4; ++c) {
+                  p[c] = UC(texel[c] * 255.f + 0.5f);
+               }
+            }
+         }
+      }
+   });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U64 texture_pixels(const TextureView& view) {
+   U64 pixels = 0;
+   visit_texture_images(view, [&](const ImageView& img) {
+      ivec3 dim = img.dim();
+      pixels += U64(dim.x) * dim.y * dim.z;
+   });
+   return pixels;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+TextureView single_image_view(const TextureView& view, std::size_t layer, std::size_t face, std::size_t level) {
+   return TextureView(view.format(), view.texture_class(), view.storage(),
+                      view.base_layer() + layer, 1,
+                      view.base_face() + face, 1,
+                      view.base_level() + level, 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void copy_texture(const TextureView& src, const TextureView& dest) {
+   for (std::size_t layer = 0; layer < src.layers(); ++layer) {
+      for (std::size_t face = 0; face < src.faces(); ++face) {
+         for (std::size_t level = 0; level < src.levels(); ++level) {
+            ImageView src_img = src.image(layer, face, level);
+            ImageView dest_img = dest.image(layer, face, level);
+            ImageRegion region = pixel_region(src_img);
+            if (!blit_pixels_fast(src_img, dest_img, region)) {
+               blit_pixels(src_img, region, dest_img, region);
+            }
+         }
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const char* file_extension(TextureFileFormat file_format) {
+   switch (file_format) {
+      case TextureFileFormat::betx: return "betx";
+      case TextureFileFormat::ktx:  return "ktx";
+      case TextureFileFormat::dds:  return "dds";
+      case TextureFileFormat::png:  return "png";
+      case TextureFileFormat::tga:  return "tga";
+      case TextureFileFormat::bmp:  return "bmp";
+      case TextureFileFormat::hdr:  return "hdr";
+      case TextureFileFormat::jpeg: return "jpg";
+      default:                      return "bin";
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reads the wall time of each phase (events without a path) from a JSON
+// profile written by atex --profile-json.  Each event is on its own line.
+bool read_profile_phases(const Path& path, std::map<S, U64>& phases) {
+   std::ifstream ifs(path.string());
+   if (!ifs) {
+      return false;
+   }
+
+   const S name_prefix = "{\"name\":\"";
+   const S wall_key = "\"wall_us\":";
+   S line;
+   while (std::getline(ifs, line)) {
+      if (line.compare(0, name_prefix.size(), name_prefix) != 0 || line.find("\"path\":") != S::npos) {
+         continue;
+      }
+
+      std::size_t name_end = line.find('"', name_prefix.size());
+      std::size_t wall = line.find(wall_key);
+      if (name_end == S::npos || wall == S::npos) {
+         continue;
+      }
+
+      S name = line.substr(name_prefix.size(), name_end - name_prefix.size());
+      phases[name] += std::strtoull(line.c_str() + wall + wall_key.size(), nullptr, 10);
+   }
+   return true;
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+AtexBenchApp::AtexBenchApp(int argc, char** argv) {
+   default_log().verbosity_mask(v::info_or_worse);
+   try {
+      using namespace cli;
+      using namespace color;
+      using namespace ct;
+      Processor proc;
+
+      bool show_version = false;
+      bool show_help = false;
+      bool verbose = false;
+      S help_query;
+
+      proc
+         (prologue (Table() << header << "ATEX BENCHMARKS").query())
+
+         (synopsis (Cell() << fg_dark_gray << "[ " << fg_cyan << "OPTIONS" << fg_dark_gray << " ]"))
+
+         (abstract ("Times each stage of the atex texture pipeline on synthetic textures and writes the results as JSON lines."))
+
+         (summary (Cell() << "Each line of output is an object with the fields " << fg_cyan << "benchmark" << reset << ", "
+                          << fg_cyan << "iterations" << reset << ", " << fg_cyan << "min_us" << reset << ", "
+                          << fg_cyan << "median_us" << reset << ", " << fg_cyan << "max_us" << reset << ", "
+                          << fg_cyan << "pixels" << reset << ", " << fg_cyan << "bytes" << reset << ", and "
+                          << fg_cyan << "mpix_per_s" << reset << ", in that order.  Benchmarks are always run in the same order.").verbose())
+
+         (summary (Cell() << "Stage benchmarks (" << fg_green << "convert" << reset << ", " << fg_green << "mipmaps" << reset << ", "
+                          << fg_green << "encode" << reset << ", " << fg_green << "decode" << reset << ", " << fg_green << "write" << reset << ", "
+                          << fg_green << "read" << reset << ") run on a single thread.  " << fg_green << "pipeline" << reset
+                          << " benchmarks run atex itself, with its usual thread pool, and report the load, merge, and write phases from its profiler.").verbose())
+
+         (numeric_param<std::size_t> ({ "n" }, { "iterations" }, "N", iterations_, 1, 10000)
+            .desc("Specifies how many timed iterations of each benchmark are run.")
+            .extra(Cell() << "Each benchmark is also run once, untimed, beforehand.  Defaults to " << fg_cyan << "5" << reset << "."))
+
+         (param ({ }, { "filter" }, "TEXT", [&](const S& str) {
+               filters_.push_back(str);
+            }).desc("Only benchmarks whose names contain the specified text will be run.")
+              .extra("May be specified multiple times; benchmarks matching any filter will be run."))
+
+         (param ({ }, { "bc-quality" }, "QUALITY", [&](const S& str) {
+               if (!parse_encode_quality(str, encode_quality_)) {
+                  throw std::runtime_error("Unrecognized block compression quality: " + str);
+               }
+            }).desc("Specifies the block compression quality used by the encode benchmarks.")
+              .extra(Cell() << "Must be one of " << fg_cyan << "fast" << reset << ", " << fg_cyan << "normal" << reset << ", or " << fg_cyan << "best"
+                            << reset << ".  Defaults to " << fg_cyan << "normal" << reset << "."))
+
+         (param ({ "o" }, { "output" }, "PATH", [&](const S& str) {
+               output_path_ = str;
+            }).desc("Writes results to the specified file instead of standard output."))
+
+         (param ({ "d" }, { "work-dir" }, "PATH", [&](const S& str) {
+               work_dir_ = str;
+            }).desc("Specifies the directory where temporary texture files are written.")
+              .extra("Defaults to an atex-bench directory inside the system's temporary directory."))
+
+         (flag ({ }, { "keep-files" }, keep_files_)
+            .desc("Temporary texture files will not be deleted when benchmarks are finished."))
+
+         (end_of_options ())
+
+         (verbosity_param ({ "v" },{ "verbosity" }, "LEVEL", default_log().verbosity_mask()))
+
+         (flag ({ "V" },{ "version" }, show_version).desc("Prints version information to standard output."))
+
+         (param ({ "?" },{ "help" }, "OPTION",
+            [&](const S& value) {
+               show_help = true;
+               help_query = value;
+            }).default_value(S())
+              .allow_options_as_values(true)
+              .desc(Cell() << "Outputs this help message.  For more verbose help, use " << fg_yellow << "--help")
+              .extra(Cell() << nl << "If " << fg_cyan << "OPTION" << reset
+                            << " is provided, the options list will be filtered to show only options that contain that string."))
+
+         (flag ({ },{ "help" }, verbose).ignore_values(true))
+
+         (exit_code (0, "All benchmarks ran successfully."))
+         (exit_code (1, "An unknown error occurred."))
+         (exit_code (2, "There was a problem parsing the command line arguments."))
+         (exit_code (3, "An I/O error occurred while writing results or temporary files."))
+         (exit_code (4, "One or more benchmarks failed."))
+
+         (example (Cell() << fg_yellow << "-n " << fg_cyan << "10" << fg_yellow << " -o " << fg_cyan << "bench.jsonl",
+            "Runs every benchmark 10 times and writes the results to bench.jsonl."))
+         (example (Cell() << fg_yellow << "--filter " << fg_cyan << "write/" << fg_yellow << " --filter " << fg_cyan << "read/",
+            "Runs only the file writer and reader benchmarks."))
+         ;
+
+      proc.process(argc, argv);
+
+      if (show_version) {
+         proc
+            (prologue (BE_ATEX_BENCH_VERSION_STRING).query())
+            (prologue (BE_ATEX_VERSION_STRING).query())
+            (prologue (BE_GFX_VERSION_STRING).query())
+            (license (BE_LICENSE).query())
+            (license (BE_COPYRIGHT).query())
+            ;
+      }
+
+      if (show_help) {
+         proc.describe(std::cout, verbose, help_query);
+      } else if (show_version) {
+         proc.describe(std::cout, verbose, ids::cli_describe_section_prologue);
+         proc.describe(std::cout, verbose, ids::cli_describe_section_license);
+      }
+
+      if (show_help || show_version) {
+         iterations_ = 0;
+      }
+
+   } catch (const cli::OptionError& e) {
+      status_ = status_cli_error;
+      log_exception(e);
+   } catch (const cli::ArgumentError& e) {
+      status_ = status_cli_error;
+      log_exception(e);
+   } catch (const FatalTrace& e) {
+      status_ = status_cli_error;
+      log_exception(e);
+   } catch (const RecoverableTrace& e) {
+      status_ = status_cli_error;
+      log_exception(e);
+   } catch (const std::exception& e) {
+      status_ = status_cli_error;
+      log_exception(e);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int AtexBenchApp::operator()() {
+   if (status_ != status_ok || iterations_ == 0) {
+      return status_;
+   }
+
+   try {
+      std::ofstream ofs;
+      os_ = &std::cout;
+      if (!output_path_.empty()) {
+         ofs.open(output_path_, std::ios::out | std::ios::trunc);
+         if (!ofs) {
+            status_ = status_io_error;
+            log_exception(fs::filesystem_error("Failed to open output file", output_path_, std::make_error_code(std::errc::io_error)));
+            return status_;
+         }
+         os_ = &ofs;
+      }
+
+      if (work_dir_.empty()) {
+         work_dir_ = fs::temp_directory_path() / "atex-bench";
+      }
+      fs::create_directories(work_dir_);
+
+      // Specs are never reordered or renamed, so that results stay comparable
+      // across commits; new specs go at the end.
+      const texture_spec_ specs[] = {
+         { "planar-256",       TextureClass::planar,       1,  1, 1,  256,  false },
+         { "planar-2048",      TextureClass::planar,       1,  1, 1,  2048, false },
+         { "planar-1024-mips", TextureClass::planar,       1,  1, 0,  1024, false },
+         { "array-512x16",     TextureClass::planar_array, 16, 1, 1,  512,  false },
+         { "cube-512-mips",    TextureClass::directional,  1,  6, 0,  512,  false },
+         { "planar-1024-hdr",  TextureClass::planar,       1,  1, 1,  1024, true  },
+      };
+
+      for (const texture_spec_& spec : specs) {
+         ivec3 dim(spec.size, spec.size, 1);
+         std::size_t levels = spec.levels > 0 ? spec.levels : mipmap_levels(dim);
+         Texture tex = make_texture(spec.hdr ? rgba32f_format() : rgba8_format(Colorspace::srgb),
+                                    spec.texture_class, spec.layers, spec.faces, levels, dim);
+         fill_texture(tex.view, spec.hdr);
+
+         bench_convert_(spec, tex.view);
+         bench_mipmaps_(spec, tex.view);
+         bench_block_codecs_(spec, tex.view);
+         bench_files_(spec, tex.view);
+      }
+
+      {
+         ivec3 dim(1024, 1024, 1);
+         Texture tex = make_texture(rgba8_format(Colorspace::srgb), TextureClass::planar, 1, 1, mipmap_levels(dim), dim);
+         fill_texture(tex.view, false);
+
+         std::vector<Path> inputs;
+         for (std::size_t level = 0; level < tex.view.levels(); ++level) {
+            inputs.push_back(work_path_("pipeline-levels-level" + std::to_string(level) + ".png"));
+         }
+         if (selected_("pipeline/png-levels-to-betx/1024")) {
+            for (std::size_t level = 0; level < tex.view.levels(); ++level) {
+               write_file_(single_image_view(tex.view, 0, 0, level), TextureFileFormat::png, false, inputs[level]);
+            }
+         }
+         bench_pipeline_("pipeline/png-levels-to-betx/1024", inputs, { work_path_("pipeline-levels.betx").string() }, texture_pixels(tex.view));
+      }
+
+      {
+         ivec3 dim(512, 512, 1);
+         Texture tex = make_texture(rgba8_format(Colorspace::srgb), TextureClass::planar_array, 16, 1, 1, dim);
+         fill_texture(tex.view, false);
+
+         std::vector<Path> inputs;
+         for (std::size_t layer = 0; layer < tex.view.layers(); ++layer) {
+            inputs.push_back(work_path_("pipeline-layers-layer" + std::to_string(layer) + ".png"));
+         }
+         if (selected_("pipeline/png-layers-to-ktx/512x16")) {
+            for (std::size_t layer = 0; layer < tex.view.layers(); ++layer) {
+               write_file_(single_image_view(tex.view, layer, 0, 0), TextureFileFormat::png, false, inputs[layer]);
+            }
+         }
+         bench_pipeline_("pipeline/png-layers-to-ktx/512x16", inputs, { work_path_("pipeline-layers.ktx").string() }, texture_pixels(tex.view));
+      }
+
+      {
+         ivec3 dim(2048, 2048, 1);
+         Texture tex = make_texture(rgba8_format(Colorspace::srgb), TextureClass::planar, 1, 1, 1, dim);
+         fill_texture(tex.view, false);
+
+         std::vector<Path> inputs { work_path_("pipeline-generate-mips.png") };
+         if (selected_("pipeline/png-generate-mips-to-betx/2048")) {
+            write_file_(tex.view, TextureFileFormat::png, false, inputs[0]);
+         }
+         bench_pipeline_("pipeline/png-generate-mips-to-betx/2048", inputs, { "--generate-mips", work_path_("pipeline-generate-mips.betx").string() },
+                         texture_pixels(tex.view));
+      }
+
+      if (!keep_files_) {
+         for (const Path& path : work_files_) {
+            std::error_code ec;
+            fs::remove(path, ec);
+         }
+      }
+
+      os_->flush();
+      if (!*os_) {
+         status_ = status_io_error;
+      }
+
+   } catch (const FatalTrace& e) {
+      status_ = status_exception;
+      log_exception(e);
+   } catch (const RecoverableTrace& e) {
+      status_ = status_exception;
+      log_exception(e);
+   } catch (const fs::filesystem_error& e) {
+      status_ = status_io_error;
+      log_exception(e);
+   } catch (const std::system_error& e) {
+      status_ = status_exception;
+      log_exception(e);
+   } catch (const std::exception& e) {
+      status_ = status_exception;
+      log_exception(e);
+   }
+
+   os_ = nullptr;
+   return status_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool AtexBenchApp::selected_(const S& name) const {
+   if (filters_.empty()) {
+      return true;
+   }
+   for (const S& filter : filters_) {
+      if (name.find(filter) != S::npos) {
+         return true;
+      }
+   }
+   return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexBenchApp::run_(const S& name, U64 pixels, U64 bytes, const std::function<bool()>& func) {
+   if (!selected_(name)) {
+      return;
+   }
+
+   be_short_verbose() << "Running benchmark: " << name | default_log();
+
+   if (!func()) {
+      fail_(name, "Warmup iteration failed");
+      return;
+   }
+
+   std::vector<U64> samples;
+   for (std::size_t i = 0; i < iterations_; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      bool ok = func();
+      auto end = std::chrono::steady_clock::now();
+      if (!ok) {
+         fail_(name, "Timed iteration failed");
+         return;
+      }
+      samples.push_back(U64(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+   }
+
+   report_(name, std::move(samples), pixels, bytes);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexBenchApp::report_(const S& name, std::vector<U64> samples, U64 pixels, U64 bytes) {
+   std::sort(samples.begin(), samples.end());
+   U64 median_us = samples[samples.size() / 2];
+   if (samples.size() % 2 == 0) {
+      median_us = (samples[samples.size() / 2 - 1] + median_us) / 2;
+   }
+
+   char mpix_per_s[32];
+   std::snprintf(mpix_per_s, sizeof(mpix_per_s), "%.3f", median_us > 0 ? F64(pixels) / F64(median_us) : 0.0);
+
+   *os_ << "{\"benchmark\":\"" << name << '"'
+        << ",\"iterations\":" << samples.size()
+        << ",\"min_us\":" << samples.front()
+        << ",\"median_us\":" << median_us
+        << ",\"max_us\":" << samples.back()
+        << ",\"pixels\":" << pixels
+        << ",\"bytes\":" << bytes
+        << ",\"mpix_per_s\":" << mpix_per_s
+        << "}\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexBenchApp::fail_(const S& name, const S& reason) {
+   status_ = status_benchmark_error;
+   be_error() << "Benchmark failed"
+      & attr("Benchmark") << name
+      & attr("Reason") << reason
+      | default_log();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexBenchApp::bench_convert_(const texture_spec_& spec, const TextureView& src) {
+   struct target {
+      const char* name;
+      ImageFormat format;
+   };
+
+   std::vector<target> targets;
+   if (spec.hdr) {
+      targets.push_back(target { "rgba8-srgb", rgba8_format(Colorspace::srgb) });
+   } else {
+      targets.push_back(target { "rgba8-linear", rgba8_format(Colorspace::linear_srgb) });
+      targets.push_back(target { "bgra8-srgb", bgra8_format(Colorspace::srgb) });
+      targets.push_back(target { "rgba32f", rgba32f_format() });
+   }
+
+   for (const target& t : targets) {
+      S name = "convert/" + spec.name + "/" + t.name;
+      if (!selected_(name)) {
+         continue;
+      }
+
+      Texture dest = make_texture(t.format, src.texture_class(), src.layers(), src.faces(), src.levels(), src.image().dim());
+      run_(name, texture_pixels(src), 0, [&]() {
+         copy_texture(src, dest.view);
+         return true;
+      });
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexBenchApp::bench_mipmaps_(const texture_spec_& spec, const TextureView& src) {
+   if (src.levels() < 2) {
+      return;
+   }
+
+   std::vector<U8> provided(src.levels());
+   provided[0] = 1;
+
+   const MipmapFilter filters[] = { MipmapFilter::box, MipmapFilter::kaiser, MipmapFilter::lanczos };
+   for (MipmapFilter filter : filters) {
+      S name = S("mipmaps/") + spec.name + "/" + mipmap_filter_name(filter);
+      if (!selected_(name)) {
+         continue;
+      }
+
+      // Mipmaps are generated in a copy so later benchmarks see the
+      // original synthetic levels.
+      Texture dest = make_texture(src.format(), src.texture_class(), src.layers(), src.faces(), src.levels(), src.image().dim());
+      copy_texture(src, dest.view);
+
+      MipmapOptions options;
+      options.filter = filter;
+
+      U64 pixels = texture_pixels(src) - U64(src.layers()) * src.faces() * src.image().dim().x * src.image().dim().y;
+      run_(name, pixels, 0, [&]() {
+         for (std::size_t layer = 0; layer < dest.view.layers(); ++layer) {
+            for (std::size_t face = 0; face < dest.view.faces(); ++face) {
+               generate_mipmaps(dest.view, layer, face, provided, options);
+            }
+         }
+         return true;
+      });
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexBenchApp::bench_block_codecs_(const texture_spec_& spec, const TextureView& src) {
+   if (spec.hdr) {
+      return;
+   }
+
+   struct codec {
+      const char* name;
+      BlockPacking packing;
+   };
+
+   const codec codecs[] = {
+      { "bc1", BlockPacking::c_s3tc1 },
+      { "bc3", BlockPacking::c_s3tc3 },
+      { "bc7", BlockPacking::c_bptc }
+   };
+
+   for (const codec& c : codecs) {
+      S encode_name = S("encode/") + spec.name + "/" + c.name;
+      S decode_name = S("decode/") + spec.name + "/" + c.name;
+      if (!selected_(encode_name) && !selected_(decode_name)) {
+         continue;
+      }
+
+      ImageFormat format = block_format(c.packing);
+      if (!can_encode_blocks(format) || !can_decode_blocks(format)) {
+         continue;
+      }
+
+      Texture blocks = make_texture(format, src.texture_class(), src.layers(), src.faces(), src.levels(), src.image().dim());
+      Texture texels = make_texture(block_codec_texel_format(format), src.texture_class(), src.layers(), src.faces(), src.levels(), src.image().dim());
+
+      auto encode = [&]() {
+         visit_texture_images(blocks.view, [&](const ImageView& img) {
+            I32 rows = (img.dim().y + 3) / 4;
+            encode_block_rows(src.image(img.layer(), img.face(), img.level()), img, 0, rows, encode_quality_);
+         });
+         return true;
+      };
+
+      auto decode = [&]() {
+         visit_texture_images(blocks.view, [&](const ImageView& img) {
+            I32 rows = (img.dim().y + 3) / 4;
+            decode_block_rows(img, texels.view.image(img.layer(), img.face(), img.level()), 0, rows);
+         });
+         return true;
+      };
+
+      run_(encode_name, texture_pixels(src), 0, encode);
+
+      if (selected_(decode_name)) {
+         if (!selected_(encode_name)) {
+            encode();
+         }
+         run_(decode_name, texture_pixels(src), 0, decode);
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexBenchApp::bench_files_(const texture_spec_& spec, const TextureView& src) {
+   struct file_type {
+      const char* name;
+      TextureFileFormat file_format;
+      bool compress;
+   };
+
+   std::vector<file_type> types {
+      { "betx", TextureFileFormat::betx, false },
+      { "betx-zlib", TextureFileFormat::betx, true },
+      { "ktx", TextureFileFormat::ktx, false },
+      { "dds", TextureFileFormat::dds, false }
+   };
+
+   // Image writers only ever see the base image, so they are only run for
+   // textures which consist of a single image.
+   if (src.layers() == 1 && src.faces() == 1 && src.levels() == 1) {
+      if (spec.hdr) {
+         types.push_back(file_type { "hdr", TextureFileFormat::hdr, false });
+      } else {
+         types.push_back(file_type { "png", TextureFileFormat::png, false });
+         types.push_back(file_type { "tga", TextureFileFormat::tga, false });
+         types.push_back(file_type { "tga-rle", TextureFileFormat::tga, true });
+         types.push_back(file_type { "bmp", TextureFileFormat::bmp, false });
+         types.push_back(file_type { "jpeg", TextureFileFormat::jpeg, false });
+      }
+   }
+
+   for (const file_type& type : types) {
+      S write_name = S("write/") + spec.name + "/" + type.name;
+      S read_name = S("read/") + spec.name + "/" + type.name;
+      if (!selected_(write_name) && !selected_(read_name)) {
+         continue;
+      }
+
+      Path path = work_path_(spec.name + "-" + type.name + "." + file_extension(type.file_format));
+      std::error_code ec = write_file_(src, type.file_format, type.compress, path);
+      if (ec) {
+         fail_(write_name, ec.message());
+         continue;
+      }
+
+      U64 size = fs::file_size(path, ec);
+      U64 pixels = type.file_format == TextureFileFormat::betx ||
+                   type.file_format == TextureFileFormat::ktx ||
+                   type.file_format == TextureFileFormat::dds ? texture_pixels(src) : texture_pixels(single_image_view(src, 0, 0, 0));
+
+      run_(write_name, pixels, size, [&]() {
+         return !write_file_(src, type.file_format, type.compress, path);
+      });
+
+      run_(read_name, pixels, size, [&]() {
+         TextureReader reader;
+         reader.reset(type.file_format);
+         std::error_code read_ec;
+         reader.read(path, read_ec);
+         if (read_ec) {
+            return false;
+         }
+         Texture tex = reader.texture(read_ec);
+         return !read_ec && bool(tex.view);
+      });
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexBenchApp::bench_pipeline_(const S& name, const std::vector<Path>& inputs, const std::vector<S>& output_args, U64 pixels) {
+   if (!selected_(name)) {
+      return;
+   }
+
+   be_short_verbose() << "Running benchmark: " << name | default_log();
+
+   Path profile_path = work_path_("pipeline-profile.json");
+
+   std::vector<S> args { "atex", "--overwrite", "--profile-json", profile_path.string() };
+   for (const Path& input : inputs) {
+      args.push_back(input.string());
+   }
+   args.push_back("--");
+   args.insert(args.end(), output_args.begin(), output_args.end());
+
+   U64 input_bytes = 0;
+   for (const Path& input : inputs) {
+      std::error_code ec;
+      U64 size = fs::file_size(input, ec);
+      if (ec) {
+         fail_(name, "Input file missing: " + input.string());
+         return;
+      }
+      input_bytes += size;
+   }
+
+   const char* phase_names[] = { "Load Inputs", "Merge", "Write Outputs" };
+   const char* phase_suffixes[] = { "/load", "/merge", "/write" };
+   std::vector<U64> phase_samples[3];
+   std::vector<U64> total_samples;
+
+   // atex resets the log verbosity when it processes its command line, and
+   // its per-file messages would drown out ours, so only warnings and errors
+   // are shown while it runs.
+   auto verbosity_mask = default_log().verbosity_mask();
+
+   for (std::size_t i = 0; i <= iterations_; ++i) {
+      std::vector<char*> argv;
+      for (S& arg : args) {
+         argv.push_back(&arg[0]);
+      }
+      argv.push_back(nullptr);
+
+      AtexApp app(int(argv.size() - 1), argv.data());
+      default_log().verbosity_mask(v::warning_or_worse);
+
+      auto start = std::chrono::steady_clock::now();
+      int status = app();
+      auto end = std::chrono::steady_clock::now();
+      default_log().verbosity_mask(verbosity_mask);
+
+      std::map<S, U64> phases;
+      if (status != 0 || !read_profile_phases(profile_path, phases)) {
+         fail_(name, "atex exited with status " + std::to_string(status));
+         return;
+      }
+
+      if (i == 0) {
+         // untimed warmup
+         continue;
+      }
+
+      total_samples.push_back(U64(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+      for (std::size_t p = 0; p < 3; ++p) {
+         phase_samples[p].push_back(phases[phase_names[p]]);
+      }
+   }
+
+   for (std::size_t p = 0; p < 3; ++p) {
+      report_(name + phase_suffixes[p], std::move(phase_samples[p]), pixels, p == 0 ? input_bytes : 0);
+   }
+   report_(name + "/total", std::move(total_samples), pixels, input_bytes);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Path AtexBenchApp::work_path_(const S& filename) {
+   Path path = work_dir_ / filename;
+   if (std::find(work_files_.begin(), work_files_.end(), path) == work_files_.end()) {
+      work_files_.push_back(path);
+   }
+   return path;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::error_code AtexBenchApp::write_file_(const TextureView& view, TextureFileFormat file_format, bool compress, const Path& path) const {
+   std::error_code ec;
+   switch (file_format) {
+      case TextureFileFormat::betx:
+      {
+         BetxWriter writer;
+         writer.payload_compression(compress ? BetxWriter::PayloadCompressionMode::zlib : BetxWriter::PayloadCompressionMode::none);
+         writer.texture(view);
+         writer.write(path, ec);
+         break;
+      }
+      case TextureFileFormat::ktx:
+      {
+         KtxWriter writer;
+         writer.texture(view);
+         writer.write(path, ec);
+         break;
+      }
+      case TextureFileFormat::dds:
+      {
+         DdsWriter writer;
+         writer.texture(view);
+         writer.write(path, ec);
+         break;
+      }
+      case TextureFileFormat::png:
+      {
+         PngWriter writer;
+         writer.image(view.image(), 0);
+         writer.write(path, ec);
+         break;
+      }
+      case TextureFileFormat::tga:
+      {
+         TgaWriter writer;
+         writer.image(view.image(), 0);
+         writer.use_rle(compress);
+         writer.write(path, ec);
+         break;
+      }
+      case TextureFileFormat::bmp:
+      {
+         BmpWriter writer;
+         writer.image(view.image(), 0);
+         writer.write(path, ec);
+         break;
+      }
+      case TextureFileFormat::hdr:
+      {
+         HdrWriter writer;
+         writer.image(view.image(), 0);
+         writer.write(path, ec);
+         break;
+      }
+      case TextureFileFormat::jpeg:
+      {
+         JpegWriter writer;
+         writer.image(view.image(), 0);
+         writer.write(path, ec);
+         break;
+      }
+      default:
+         ec = std::make_error_code(std::errc::not_supported);
+         break;
+   }
+   return ec;
+}
+
+} // be::atex
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef BE_ATEX_BENCH_ATEX_BENCH_APP_HPP_
+#define BE_ATEX_BENCH_ATEX_BENCH_APP_HPP_
+
+#include "../src-atex/block_encoder.hpp"
+#include "../src-atex/mipmap_generator.hpp"
+#include <be/core/lifecycle.hpp>
+#include <be/core/filesystem.hpp>
+#include <be/gfx/tex/texture.hpp>
+#include <be/gfx/tex/texture_file_format.hpp>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+// Times each stage of the atex pipeline on synthetic textures: texel format
+// conversion, mipmap generation, block encoding/decoding, each writer,
+// TextureReader, and whole atex runs (load/merge/write, as reported by
+// atex's own profiler).  Results are written as one JSON object per line,
+// in a fixed order, so runs from different commits can be compared.
+class AtexBenchApp final {
+public:
+   AtexBenchApp(int argc, char** argv);
+
+   int operator()();
+
+private:
+   enum status_code_ : U8 {
+      status_ok = 0,
+      status_exception,
+      status_cli_error,
+      status_io_error,
+      status_benchmark_error
+   };
+
+   struct texture_spec_ {
+      S name;
+      gfx::tex::TextureClass texture_class;
+      std::size_t layers;
+      std::size_t faces;
+      std::size_t levels;
+      I32 size;
+      bool hdr;
+   };
+
+   bool selected_(const S& name) const;
+   void run_(const S& name, U64 pixels, U64 bytes, const std::function<bool()>& func);
+   void report_(const S& name, std::vector<U64> samples, U64 pixels, U64 bytes);
+   void fail_(const S& name, const S& reason);
+
+   void bench_convert_(const texture_spec_& spec, const gfx::tex::TextureView& src);
+   void bench_mipmaps_(const texture_spec_& spec, const gfx::tex::TextureView& src);
+   void bench_block_codecs_(const texture_spec_& spec, const gfx::tex::TextureView& src);
+   void bench_files_(const texture_spec_& spec, const gfx::tex::TextureView& src);
+   void bench_pipeline_(const S& name, const std::vector<Path>& inputs, const std::vector<S>& output_args, U64 pixels);
+
+   Path work_path_(const S& filename);
+   std::error_code write_file_(const gfx::tex::TextureView& view, gfx::tex::TextureFileFormat file_format,
+                               bool compress, const Path& path) const;
+
+   CoreInitLifecycle init_;
+   I8 status_ = status_ok;
+
+   std::size_t iterations_ = 5;
+   std::vector<S> filters_;
+   Path work_dir_;
+   bool keep_files_ = false;
+   std::vector<Path> work_files_;
+   S output_path_;
+   EncodeQuality encode_quality_ = EncodeQuality::normal;
+
+   std::ostream* os_ = nullptr;
+};
+
+} // be::atex
+
+#endif
@@ -1,4 +1,7 @@
 #include "atex_app.hpp"
+#include "block_codec.hpp"
+#include "blit_kernels.hpp"
+#include "dds_writer.hpp"
 #include <be/core/log_exception.hpp>
 #include <be/core/logging.hpp>
 #include <be/util/paths.hpp>
@@ -6,7 +9,6 @@
 #include <be/util/parse_numeric_string.hpp>
 #include <be/gfx/tex/visit_texture.hpp>
 #include <be/gfx/tex/texture_reader.hpp>
-#include <be/gfx/tex/duplicate_texture.hpp>
 #include <be/gfx/tex/log_texture_info.hpp>
 #include <be/gfx/tex/mipmapping.hpp>
 #include <be/gfx/tex/blit_pixels.hpp>
@@ -17,14 +19,49 @@
 #include <be/gfx/tex/jpeg_writer.hpp>
 #include <be/gfx/tex/png_writer.hpp>
 #include <be/gfx/tex/tga_writer.hpp>
-#include <map>
+#include <fstream>
+#include <unordered_map>
 
 namespace be::atex {
 
 using namespace be::gfx::tex;
 
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+U64 texture_pixels(const TextureView& view) {
+   U64 pixels = 0;
+   if (view) {
+      for (std::size_t layer = 0; layer < view.layers(); ++layer) {
+         for (std::size_t face = 0; face < view.faces(); ++face) {
+            for (std::size_t level = 0; level < view.levels(); ++level) {
+               ivec3 dim = view.image(layer, face, level).dim();
+               pixels += U64(dim.x) * dim.y * dim.z;
+            }
+         }
+      }
+   }
+   return pixels;
+}
+
+} // be::atex::()
+
 ///////////////////////////////////////////////////////////////////////////////
 int AtexApp::operator()() {
+   if (!batch_manifest_.empty()) {
+      if (status_ == 0) {
+         run_batch_();
+      }
+      return status_;
+   }
+
+   if (!server_socket_path_.empty()) {
+      if (status_ == 0) {
+         run_server_();
+      }
+      return status_;
+   }
+
    if (output_files_.empty()) {
       set_status_(status_no_output);
    }
@@ -37,31 +74,12 @@ int AtexApp::operator()() {
       return status_;
    }
 
-   try {
-      if (input_search_paths_.empty()) {
-         input_search_paths_.push_back(util::cwd());
-      }
-
-      if (output_path_base_.empty()) {
-         output_path_base_ = util::cwd();
-      }
-
-      std::vector<input_> inputs = load_inputs_();
-      if (inputs.empty()) {
-         set_status_(status_no_input);
-         return status_;
-      }
-
-      Texture tex = make_texture_(inputs);
-      if (!tex.view) {
-         set_status_(status_conversion_error);
-         return status_;
-      }
-
-      log_texture_info(tex.view, "Texture Info");
-
-      write_outputs_(tex.view);
+   if (profile_ || !profile_json_path_.empty() || !profile_trace_path_.empty()) {
+      profiler_ = std::make_unique<Profiler>();
+   }
 
+   try {
+      convert_();
    } catch (const FatalTrace& e) {
       set_status_(status_exception);
       log_exception(e);
@@ -79,9 +97,125 @@ int AtexApp::operator()() {
       log_exception(e);
    }
 
+   if (profiler_) {
+      report_profile_();
+   }
+
    return status_;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::convert_() {
+   if (input_search_paths_.empty()) {
+      input_search_paths_.push_back(util::cwd());
+   }
+
+   if (output_path_base_.empty()) {
+      output_path_base_ = util::cwd();
+   }
+
+   S cache_key;
+   if (!cache_dir_.empty()) {
+      Profiler::Scope scope(profiler_.get(), "Cache Lookup");
+      cache_key = cache_key_();
+      if (!cache_key.empty() && restore_cached_outputs_(cache_key)) {
+         return;
+      }
+   }
+
+   std::vector<input_> inputs;
+   {
+      Profiler::Scope scope(profiler_.get(), "Load Inputs");
+      inputs = load_inputs_();
+      for (const input_& input : inputs) {
+         std::error_code ec;
+         U64 size = fs::file_size(input.path, ec);
+         scope.bytes_read(ec ? 0 : size);
+         for (const input_image_& img : input.images) {
+            scope.pixels(U64(img.dim.x) * img.dim.y * img.dim.z);
+         }
+      }
+   }
+
+   if (inputs.empty()) {
+      set_status_(status_no_input);
+      return;
+   }
+
+   Texture tex;
+   {
+      Profiler::Scope scope(profiler_.get(), "Merge");
+      tex = make_texture_(inputs);
+      scope.pixels(texture_pixels(tex.view));
+   }
+
+   if (!tex.view) {
+      set_status_(status_conversion_error);
+      return;
+   }
+
+   log_texture_info(tex.view, "Texture Info");
+
+   std::vector<Path> written;
+   {
+      Profiler::Scope scope(profiler_.get(), "Write Outputs");
+      written = write_outputs_(tex.view);
+      for (const Path& path : written) {
+         std::error_code ec;
+         U64 size = fs::file_size(path, ec);
+         scope.bytes_written(ec ? 0 : size);
+      }
+   }
+
+   if (!cache_key.empty() && status_ <= status_warning) {
+      Profiler::Scope scope(profiler_.get(), "Cache Store");
+      store_cached_outputs_(cache_key, written);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::report_profile_() {
+   for (const Profiler::Event& event : profiler_->events()) {
+      if (event.path.empty()) {
+         be_info() << "Phase finished: " << event.name
+            & attr("Wall Time (ms)") << (event.wall_us / 1000.0)
+            & attr("CPU Time (ms)") << (event.cpu_us / 1000.0)
+            & attr("Bytes Read") << event.bytes_read
+            & attr("Bytes Written") << event.bytes_written
+            & attr("Pixels") << event.pixels
+            & attr("Peak RSS") << event.peak_rss
+            | default_log();
+      } else {
+         be_verbose() << event.name << " finished: " << event.path
+            & attr("Thread") << event.thread
+            & attr("Wall Time (ms)") << (event.wall_us / 1000.0)
+            & attr("CPU Time (ms)") << (event.cpu_us / 1000.0)
+            & attr("Bytes Read") << event.bytes_read
+            & attr("Bytes Written") << event.bytes_written
+            & attr("Pixels") << event.pixels
+            | default_log();
+      }
+   }
+
+   if (!profile_json_path_.empty()) {
+      std::ofstream ofs(profile_json_path_, std::ios::out | std::ios::trunc);
+      profiler_->write_json(ofs);
+      if (!ofs) {
+         set_status_(status_write_error);
+         log_exception(fs::filesystem_error("Error writing profile!", profile_json_path_, std::make_error_code(std::errc::io_error)));
+      }
+   }
+
+   if (!profile_trace_path_.empty()) {
+      std::ofstream ofs(profile_trace_path_, std::ios::out | std::ios::trunc);
+      profiler_->write_chrome_trace(ofs);
+      if (!ofs) {
+         set_status_(status_write_error);
+         log_exception(fs::filesystem_error("Error writing profile trace!", profile_trace_path_, std::make_error_code(std::errc::io_error)));
+      }
+   }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 void AtexApp::set_status_(status_code_ status) {
    if (status > status_) {
@@ -90,77 +224,138 @@ void AtexApp::set_status_(status_code_ status) {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-std::vector<AtexApp::input_> AtexApp::load_inputs_() {
-   std::vector<input_> inputs;
-   std::map<std::size_t, std::size_t> images;
+tools::JobPool& AtexApp::job_pool_() {
+   if (shared_job_pool_) {
+      return *shared_job_pool_;
+   }
+   if (!job_pool_ptr_) {
+      job_pool_ptr_ = std::make_unique<tools::JobPool>(jobs_);
+   }
+   return *job_pool_ptr_;
+}
 
-   for (input_file_ file : input_files_) {
+///////////////////////////////////////////////////////////////////////////////
+std::vector<AtexApp::input_> AtexApp::load_inputs_() {
+   struct pending_input {
+      input_file_ file;
+      bool matched = false;
+      decoded_input_ decoded;
+   };
+
+   std::vector<pending_input> pending;
+   for (const input_file_& file : input_files_) {
       std::vector<Path> paths = util::glob(file.path.string(), input_search_paths_, util::PathMatchType::files_and_misc);
       if (paths.empty()) {
-         set_status_(status_warning);
-         be_short_warn() << "No files matched input file pattern: " << file.path.string() | default_log();
+         pending.push_back(pending_input { file });
       } else {
          for (const Path& p : paths) {
-            file.path = p;
-            input_ input = load_input_(file);
-            if (input.texture.view) {
-               visit_texture_images(input.texture.view, [&](const ImageView& img) {
-
-                  std::size_t layer = input.dest_layer + img.layer();
-                  if (layer >= TextureStorage::max_layers) {
-                     set_status_(status_warning);
-                     be_warn() << "Too many layers; ignoring overflow!"
-                        & attr("Source") << input.path.string()
-                        & attr("Source Layer") << (file.first_layer + img.layer())
-                        & attr("Dest Layer") << layer
-                        | default_log();
-                     return;
-                  }
-
-                  std::size_t face = input.dest_face + img.face();
-                  if (face >= TextureStorage::max_faces) {
-                     set_status_(status_warning);
-                     be_warn() << "Too many faces; ignoring overflow!"
-                        & attr("Source") << input.path.string()
-                        & attr("Source Face") << (file.first_face + img.face())
-                        & attr("Dest Face") << face
-                        | default_log();
-                     return;
-                  }
-
-                  std::size_t level = input.dest_level + img.level();
-                  if (level >= TextureStorage::max_levels) {
-                     set_status_(status_warning);
-                     be_warn() << "Too many levels; ignoring overflow!"
-                        & attr("Source") << input.path.string()
-                        & attr("Source Level") << (file.first_level + img.level())
-                        & attr("Dest Level") << level
-                        | default_log();
-                     return;
-                  }
-
-                  constexpr int layer_bits = 8 * sizeof(TextureStorage::layer_index_type);
-                  constexpr int face_bits = 8 * sizeof(TextureStorage::face_index_type);
-                  constexpr int level_bits = 8 * sizeof(TextureStorage::level_index_type);
-
-                  std::size_t img_id = (layer << (face_bits + level_bits)) | (face << level_bits) | level;
-                  auto result = images.insert(std::make_pair(img_id, inputs.size()));
-                  if (!result.second) {
-                     set_status_(status_warning);
-                     be_warn() << "Replacing an image that was already loaded!"
-                        & attr("Layer") << std::size_t(img.layer())
-                        & attr("Face") << std::size_t(img.face())
-                        & attr("Level") << std::size_t(img.level())
-                        & attr("Old Source") << inputs[result.first->second].path.string()
-                        & attr("New Source") << input.path.string()
-                        | default_log();
-
-                     result.first->second = inputs.size();
-                  }
-               });
-
-               inputs.push_back(std::move(input));
+            pending.push_back(pending_input { file, true });
+            pending.back().file.path = p;
+         }
+      }
+   }
+
+   // Decoding doesn't log or touch status_, so it can happen on any thread.
+   // Everything else happens below, in the same order as the inputs were
+   // specified, so that warnings and layer/face/level collisions are resolved
+   // exactly as they would be if each file were loaded serially.  In two-pass
+   // mode each texture is released as soon as its images have been recorded,
+   // so only decode as many files at a time as there are threads to do it.
+   std::size_t batch_size = two_pass_merge_ ? job_pool_().concurrency() : pending.size();
+
+   std::vector<input_> inputs;
+   ImageSlotTable<std::size_t> images(std::size_t(-1));
+
+   for (std::size_t batch_begin = 0; batch_begin < pending.size(); batch_begin += batch_size) {
+      std::size_t batch_end = std::min(pending.size(), batch_begin + batch_size);
+
+      job_pool_().run(batch_end - batch_begin, [&](std::size_t i) {
+         pending_input& entry = pending[batch_begin + i];
+         if (entry.matched) {
+            entry.decoded = read_input_(entry.file);
+         }
+      });
+
+      for (std::size_t i = batch_begin; i < batch_end; ++i) {
+         pending_input& entry = pending[i];
+         const input_file_& file = entry.file;
+         if (!entry.matched) {
+            set_status_(status_warning);
+            be_short_warn() << "No files matched input file pattern: " << file.path.string() | default_log();
+            continue;
+         }
+
+         input_ input = load_input_(file, std::move(entry.decoded));
+         if (input.texture.view) {
+            const TextureView& view = input.texture.view;
+            images.include(input.dest_layer, std::min<std::size_t>(input.dest_layer + view.layers(), TextureStorage::max_layers) - 1,
+                           input.dest_face, std::min<std::size_t>(input.dest_face + view.faces(), TextureStorage::max_faces) - 1,
+                           input.dest_level, std::min<std::size_t>(input.dest_level + view.levels(), TextureStorage::max_levels) - 1);
+
+            visit_texture_images(input.texture.view, [&](const ImageView& img) {
+
+               std::size_t layer = input.dest_layer + img.layer();
+               if (layer >= TextureStorage::max_layers) {
+                  set_status_(status_warning);
+                  be_warn() << "Too many layers; ignoring overflow!"
+                     & attr("Source") << input.path.string()
+                     & attr("Source Layer") << (file.first_layer + img.layer())
+                     & attr("Dest Layer") << layer
+                     | default_log();
+                  return;
+               }
+
+               std::size_t face = input.dest_face + img.face();
+               if (face >= TextureStorage::max_faces) {
+                  set_status_(status_warning);
+                  be_warn() << "Too many faces; ignoring overflow!"
+                     & attr("Source") << input.path.string()
+                     & attr("Source Face") << (file.first_face + img.face())
+                     & attr("Dest Face") << face
+                     | default_log();
+                  return;
+               }
+
+               std::size_t level = input.dest_level + img.level();
+               if (level >= TextureStorage::max_levels) {
+                  set_status_(status_warning);
+                  be_warn() << "Too many levels; ignoring overflow!"
+                     & attr("Source") << input.path.string()
+                     & attr("Source Level") << (file.first_level + img.level())
+                     & attr("Dest Level") << level
+                     | default_log();
+                  return;
+               }
+
+               std::size_t& slot = images(layer, face, level);
+               if (slot != images.empty_value()) {
+                  set_status_(status_warning);
+                  be_warn() << "Replacing an image that was already loaded!"
+                     & attr("Layer") << std::size_t(img.layer())
+                     & attr("Face") << std::size_t(img.face())
+                     & attr("Level") << std::size_t(img.level())
+                     & attr("Old Source") << inputs[slot].path.string()
+                     & attr("New Source") << input.path.string()
+                     | default_log();
+               }
+               slot = inputs.size();
+
+               input_image_ record;
+               record.src_layer = TextureStorage::layer_index_type(img.layer());
+               record.src_face = TextureStorage::face_index_type(img.face());
+               record.src_level = TextureStorage::level_index_type(img.level());
+               record.layer = TextureStorage::layer_index_type(layer);
+               record.face = TextureStorage::face_index_type(face);
+               record.level = TextureStorage::level_index_type(level);
+               record.dim = img.dim();
+               input.images.push_back(record);
+            });
+
+            if (two_pass_merge_) {
+               input.texture = Texture();
             }
+
+            inputs.push_back(std::move(input));
          }
       }
    }
@@ -196,9 +391,40 @@ const std::regex& depth_regex() {
 } // be::atex::()
 
 ///////////////////////////////////////////////////////////////////////////////
-AtexApp::input_ AtexApp::load_input_(const input_file_& file) {
+AtexApp::decoded_input_ AtexApp::read_input_(const input_file_& file) const {
+   decoded_input_ result;
+
+   if (file.first_layer > file.last_layer ||
+       file.first_face > file.last_face ||
+       file.first_level > file.last_level) {
+      return result;
+   }
+
+   Profiler::Scope scope(profiler_.get(), "Read", file.path.string());
+   TextureReader reader;
+   if (file.file_format != TextureFileFormat::unknown) {
+      reader.reset(file.file_format);
+   }
+
+   reader.read(file.path, result.read_error);
+   if (!result.read_error) {
+      result.texture = reader.texture(result.parse_error);
+      result.file_format = reader.format();
+
+      std::error_code ec;
+      U64 size = fs::file_size(file.path, ec);
+      scope.bytes_read(ec ? 0 : size);
+      scope.pixels(texture_pixels(result.texture.view));
+   }
+
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+AtexApp::input_ AtexApp::load_input_(const input_file_& file, decoded_input_ decoded) {
    input_ result;
    result.path = file.path;
+   result.file = file;
    result.dest_layer = file.layer;
    result.dest_face = file.face;
    result.dest_level = file.level;
@@ -292,46 +518,36 @@ AtexApp::input_ AtexApp::load_input_(const input_file_& file) {
       }
    }
 
-   TextureReader reader;
-   if (file.file_format != TextureFileFormat::unknown) {
-      reader.reset(file.file_format);
-   }
-
-   std::error_code ec;
-   reader.read(file.path, ec);
-   if (ec) {
+   if (decoded.read_error) {
       set_status_(status_read_error);
-      log_exception(std::system_error(ec, "Failed to read texture file: " + file.path.string()));
+      log_exception(std::system_error(decoded.read_error, "Failed to read texture file: " + file.path.string()));
    } else {
-      result.texture = reader.texture(ec);
-      if (ec) {
+      result.texture = std::move(decoded.texture);
+      if (decoded.parse_error) {
          set_status_(status_read_error);
-         log_exception(std::system_error(ec, "Failed to parse texture file: " + file.path.string()));
+         log_exception(std::system_error(decoded.parse_error, "Failed to parse texture file: " + file.path.string()));
       } else if (!result.texture.view) {
          set_status_(status_read_error);
          be_error() << "Loading texture file resulted in an empty texture!"
             & attr(ids::log_attr_path) << file.path.string()
             | default_log();
       } else {
-         result.file_format = reader.format();
+         result.file_format = decoded.file_format;
          TextureView& view = result.texture.view;
          log_texture_info(view, "Texture Loaded", result.path, result.file_format, v::verbose);
 
-         ImageFormat new_format = view.format();
+         TextureView new_view = select_input_view_(file, view);
+         ImageFormat new_format = new_view.format();
 
          if (file.override_colorspace) {
-            new_format.colorspace(file.colorspace);
             be_short_verbose() << "Overriding colorspace: " << file.colorspace | default_log();
          }
 
          if (file.override_premultiplied) {
-            new_format.premultiplied(file.premultiplied);
             be_short_verbose() << "Overriding premultiplied: " << (file.premultiplied ? "yes" : "no") | default_log();
          }
 
          if (file.override_components) {
-            new_format.field_types(file.field_types);
-            new_format.swizzles(file.swizzles);
             be_short_verbose() << "Overriding Component Type 0: " << new_format.field_type(0) | default_log();
             be_short_verbose() << "Overriding Component Type 1: " << new_format.field_type(1) | default_log();
             be_short_verbose() << "Overriding Component Type 2: " << new_format.field_type(2) | default_log();
@@ -342,11 +558,6 @@ AtexApp::input_ AtexApp::load_input_(const input_file_& file) {
             be_short_verbose() << "Overriding A Swizzle: " << new_format.swizzle(3) | default_log();
          }
 
-         TextureView new_view = TextureView(new_format, view.texture_class(), view.storage(),
-                                            file.first_layer, file.last_layer - file.first_layer + 1,
-                                            file.first_face, file.last_face - file.first_face + 1,
-                                            file.first_level, file.last_level - file.first_level + 1);
-
          if (new_view.layers() != view.layers() || new_view.faces() != view.faces() || new_view.levels() != view.levels()) {
             if (new_view.layers() != view.layers()) {
                if (file.first_layer > 0) {
@@ -374,16 +585,18 @@ AtexApp::input_ AtexApp::load_input_(const input_file_& file) {
                   be_short_verbose() << "Skipping Levels: [ " << std::size_t(file.last_level + 1) << ", " << std::size_t(view.levels() - 1) << " ]" | default_log();
                }
             }
+         }
 
-            try {
-               result.texture = duplicate_texture(new_view);
-            } catch (const std::bad_alloc&) {
-               view = TextureView();
-               set_status_(status_read_error);
-               log_exception(fs::filesystem_error("Not enough memory to duplicate texture", file.path, std::make_error_code(std::errc::not_enough_memory)));
-            }
-         } else {
-            view = new_view;
+         // The view may cover only part of the loaded storage; the input keeps
+         // the whole texture alive, so the selected images are only copied
+         // once, when they're blitted into the merged texture.
+         view = new_view;
+
+         if (result.texture.view) {
+            result.format = result.texture.view.format();
+            result.texture_class = result.texture.view.texture_class();
+            result.block_span = result.texture.view.block_span();
+            result.alignment = result.texture.view.storage().alignment();
          }
       }
    }
@@ -392,12 +605,35 @@ AtexApp::input_ AtexApp::load_input_(const input_file_& file) {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
+TextureView AtexApp::select_input_view_(const input_file_& file, TextureView view) {
+   ImageFormat format = view.format();
+
+   if (file.override_colorspace) {
+      format.colorspace(file.colorspace);
+   }
+
+   if (file.override_premultiplied) {
+      format.premultiplied(file.premultiplied);
+   }
+
+   if (file.override_components) {
+      format.field_types(file.field_types);
+      format.swizzles(file.swizzles);
+   }
+
+   return TextureView(format, view.texture_class(), view.storage(),
+                      file.first_layer, file.last_layer - file.first_layer + 1,
+                      file.first_face, file.last_face - file.first_face + 1,
+                      file.first_level, file.last_level - file.first_level + 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Texture AtexApp::make_texture_(std::vector<input_>& inputs) {
    Texture result;
 
    be_verbose() << "Merging input textures" | default_log();
 
-   std::map<std::size_t, std::pair<const input_*, ConstImageView>> images;
+   image_map_ images;
    TextureStorage::layer_index_type min_layer = TextureStorage::max_layers, max_layer = 0;
    TextureStorage::face_index_type min_face = TextureStorage::max_faces, max_face = 0;
    TextureStorage::level_index_type min_level = TextureStorage::max_levels, max_level = 0;
@@ -405,38 +641,33 @@ Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
    ivec3 base_dim;
 
    for (const auto& input : inputs) {
-      ConstTextureView view = input.texture.view;
-      visit_texture_images(view, [&](ConstImageView& img) {
-         std::size_t layer = input.dest_layer + img.layer();
-         std::size_t face = input.dest_face + img.face();
-         std::size_t level = input.dest_level + img.level();
-         if (layer >= TextureStorage::max_layers ||
-             face >= TextureStorage::max_faces ||
-             level >= TextureStorage::max_levels) {
-            return;
+      for (const input_image_& img : input.images) {
+         if (img.level < min_level) {
+            base_input = &input;
+            base_dim = img.dim;
          }
 
-         constexpr int layer_bits = 8 * sizeof(TextureStorage::layer_index_type);
-         constexpr int face_bits = 8 * sizeof(TextureStorage::face_index_type);
-         constexpr int level_bits = 8 * sizeof(TextureStorage::level_index_type);
+         min_layer = std::min(min_layer, img.layer);
+         max_layer = std::max(max_layer, img.layer);
 
-         std::size_t img_id = (layer << (face_bits + level_bits)) | (face << level_bits) | level;
-         images[img_id] = std::make_pair(&input, img);
+         min_face = std::min(min_face, img.face);
+         max_face = std::max(max_face, img.face);
 
-         if (level < min_level) {
-            base_input = &input;
-            base_dim = img.dim();
-         }
-
-         min_layer = std::min(min_layer, TextureStorage::layer_index_type(layer));
-         max_layer = std::max(max_layer, TextureStorage::layer_index_type(layer));
+         min_level = std::min(min_level, img.level);
+         max_level = std::max(max_level, img.level);
+      }
+   }
 
-         min_face = std::min(min_face, TextureStorage::face_index_type(face));
-         max_face = std::max(max_face, TextureStorage::face_index_type(face));
+   if (!base_input) {
+      be_error() << "No input images to merge!" | default_log();
+      return result;
+   }
 
-         min_level = std::min(min_level, TextureStorage::level_index_type(level));
-         max_level = std::max(max_level, TextureStorage::level_index_type(level));
-      });
+   images.reset(min_layer, max_layer, min_face, max_face, min_level, max_level);
+   for (const auto& input : inputs) {
+      for (const input_image_& img : input.images) {
+         images(img.layer, img.face, img.level) = image_slot_ { &input, &img };
+      }
    }
 
    if (min_layer > 0) {
@@ -465,25 +696,29 @@ Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
       max_level = min_level + expected_levels - 1;
    }
 
+   if (generate_mips_) {
+      max_level = min_level + expected_levels - 1;
+   }
+
    for (TextureStorage::layer_index_type layer = min_layer; layer <= max_layer; ++layer) {
       for (TextureStorage::face_index_type face = min_face; face <= max_face; ++face) {
+         bool have_source_level = false;
          for (TextureStorage::level_index_type level = min_level; level <= max_level; ++level) {
-            constexpr int layer_bits = 8 * sizeof(TextureStorage::layer_index_type);
-            constexpr int face_bits = 8 * sizeof(TextureStorage::face_index_type);
-            constexpr int level_bits = 8 * sizeof(TextureStorage::level_index_type);
-
-            std::size_t img_id = (layer << (face_bits + level_bits)) | (face << level_bits) | level;
-            auto it = images.find(img_id);
-            if (it == images.end()) {
+            const image_slot_* slot = images.find(layer, face, level);
+            if (!slot || !slot->input) {
+               if (generate_mips_ && have_source_level) {
+                  continue;
+               }
                set_status_(status_warning);
                be_short_warn() << "Missing image for layer " << std::size_t(layer) << " face " << std::size_t(face) << " level " << std::size_t(level) | default_log();
             } else {
-               auto dim = it->second.second.dim();
+               have_source_level = true;
+               auto dim = slot->image->dim;
                auto expected = mipmap_dim(base_dim, level);
                if (dim != expected) {
                   set_status_(status_warning);
                   be_warn() << "Image size mismatch!"
-                     & attr("Source Path") << it->second.first->path.string()
+                     & attr("Source Path") << slot->input->path.string()
                      & attr("Width") << dim.x
                      & attr("Expected Width") << expected.x
                      & attr("Height") << dim.y
@@ -500,8 +735,6 @@ Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
       }
    }
 
-   assert(base_input != nullptr);
-
    TextureStorage::layer_index_type layers = max_layer + 1;
    TextureStorage::face_index_type faces = max_face + 1;
    TextureStorage::level_index_type levels = max_level + 1;
@@ -510,7 +743,7 @@ Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
    if (override_tex_class_) {
       tex_class = tex_class_;
    } else {
-      tex_class = base_input->texture.view.texture_class();
+      tex_class = base_input->texture_class;
       if (layers > 1 && !is_array(tex_class)) {
          switch (tex_class) {
             case TextureClass::lineal: tex_class = TextureClass::lineal_array; break;
@@ -551,8 +784,8 @@ Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
          | default_log();
    }
 
-   ImageFormat format = base_input->texture.view.format();
-   U8 block_span = base_input->texture.view.block_span();
+   ImageFormat format = base_input->format;
+   U8 block_span = base_input->block_span;
    if (override_block_) {
       format.packing(packing_);
       format.block_dim(ImageFormat::block_dim_type(1));
@@ -561,6 +794,14 @@ Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
       format.field_types(field_types_);
       format.swizzles(swizzles_);
       block_span = block_span_;
+
+      if (is_compressed(packing_)) {
+         format.block_dim(ImageFormat::block_dim_type(4, 4, 1));
+         if (format.field_type(0) == FieldType::none) {
+            format.field_types(ImageFormat::field_types_type(FieldType::unorm));
+         }
+         format.block_size(ImageFormat::block_size_type(block_codec_size(block_codec(format))));
+      }
    }
 
    if (format.components() > field_count(format.packing())) {
@@ -575,7 +816,7 @@ Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
    std::size_t required_block_size = format.block_dim().x * format.block_dim().y * format.block_dim().z *
       block_word_size(format.packing()) * block_word_count(format.packing());
 
-   if (required_block_size > format.block_size()) {
+   if (!is_compressed(format.packing()) && required_block_size > format.block_size()) {
       set_status_(status_warning);
       be_notice() << "Block size enlarged to fit all block data"
          & attr("Block Packing") << format.packing()
@@ -609,45 +850,379 @@ Texture AtexApp::make_texture_(const std::vector<input_>& inputs) {
    if (override_alignment_) {
       alignment = TextureAlignment(line_alignment_bits_, plane_alignment_bits_, level_alignment_bits_, face_alignment_bits_, layer_alignment_bits_);
    } else {
-      alignment = base_input->texture.view.storage().alignment();
+      alignment = base_input->alignment;
+   }
+
+   // Compressed output is merged into an uncompressed texture first and then
+   // encoded, unless every input image is already in the output format and
+   // can be copied as-is.
+   bool encode = false;
+   if (can_encode_blocks(format)) {
+      encode = generate_mips_;
+      for (const input_& input : inputs) {
+         if (!input.images.empty() && input.format != format) {
+            encode = true;
+         }
+      }
+   }
+
+   ImageFormat merge_format = encode ? block_codec_texel_format(format) : format;
+   U8 merge_block_span = encode ? U8(merge_format.block_size()) : block_span;
+
+   // When a single input already provides every image of the output in the
+   // merge format, its storage can be used directly: passed through as-is,
+   // or encoded without merging into a new uncompressed texture first.
+   input_* sole_input = nullptr;
+   if (!two_pass_merge_ && !generate_mips_) {
+      std::size_t inputs_with_images = 0;
+      for (input_& input : inputs) {
+         if (!input.images.empty()) {
+            ++inputs_with_images;
+            sole_input = &input;
+         }
+      }
+
+      if (inputs_with_images != 1 ||
+          sole_input->format != merge_format ||
+          sole_input->dest_layer != 0 || sole_input->dest_face != 0 || sole_input->dest_level != 0 ||
+          sole_input->images.size() != std::size_t(layers) * faces * levels) {
+         sole_input = nullptr;
+      } else {
+         for (const input_image_& img : sole_input->images) {
+            if (img.src_layer != img.layer || img.src_face != img.face || img.src_level != img.level ||
+                img.dim != mipmap_dim(base_dim, img.level)) {
+               sole_input = nullptr;
+               break;
+            }
+         }
+      }
+   }
+
+   if (sole_input && encode) {
+      be_verbose() << "Encoding single input texture directly" | default_log();
+      try {
+         result.storage = std::make_unique<TextureStorage>(layers, faces, levels, base_dim, format.block_dim(), block_span, alignment);
+      } catch (const std::bad_alloc&) {
+         set_status_(status_conversion_error);
+         log_exception(std::system_error(std::make_error_code(std::errc::not_enough_memory), "Not enough memory to allocate compressed texture"));
+         return result;
+      }
+
+      result.view = TextureView(format, tex_class, *result.storage, 0, layers, 0, faces, 0, levels);
+      encode_blocks_(sole_input->texture.view, result.view);
+      return result;
+   }
+
+   if (sole_input && !override_alignment_ && sole_input->block_span == merge_block_span) {
+      const TextureView& src = sole_input->texture.view;
+      const auto& storage = src.storage();
+      if (src.base_layer() == 0 && src.base_face() == 0 && src.base_level() == 0 &&
+          storage.layers() == layers && storage.faces() == faces && storage.levels() == levels) {
+         be_verbose() << "Passing single input texture through without merging" | default_log();
+         result.storage = std::move(sole_input->texture.storage);
+         result.view = TextureView(format, tex_class, *result.storage, 0, layers, 0, faces, 0, levels);
+         return result;
+      }
    }
 
    try {
-      result.storage = std::make_unique<TextureStorage>(layers, faces, levels, base_dim, format.block_dim(), block_span, alignment);
+      result.storage = std::make_unique<TextureStorage>(layers, faces, levels, base_dim, merge_format.block_dim(), merge_block_span, alignment);
    } catch (const std::bad_alloc&) {
       set_status_(status_conversion_error);
       log_exception(std::system_error(std::make_error_code(std::errc::not_enough_memory), "Not enough memory to allocate merged texture"));
       return result;
    }
 
-   result.view = TextureView(format, tex_class, *result.storage, 0, layers, 0, faces, 0, levels);
+   result.view = TextureView(merge_format, tex_class, *result.storage, 0, layers, 0, faces, 0, levels);
+
+   if (two_pass_merge_) {
+      stream_inputs_(result.view, inputs, images);
+   } else {
+      // Compressed inputs are expanded up front so that the blits below only
+      // ever see uncompressed sources (or blocks copied as-is).
+      std::vector<Texture> decoded(inputs.size());
+      std::vector<blit_job_> jobs;
+      for (std::size_t i = 0; i < inputs.size(); ++i) {
+         const input_& input = inputs[i];
+         TextureView src = input.texture.view;
+         if (can_decode_blocks(src.format()) && src.format() != merge_format) {
+            be_verbose() << "Decoding compressed blocks"
+               & attr(ids::log_attr_path) << input.path.string()
+               & attr("Block Packing") << src.format().packing()
+               | default_log();
+            decoded[i] = decode_blocks_(src);
+            src = decoded[i].view;
+         }
+         plan_blits_(result.view, input, src, images, jobs);
+      }
+      run_blits_(jobs);
+   }
+
+   if (generate_mips_) {
+      generate_mipmaps_(result.view, images);
+   }
+
+   if (encode) {
+      Texture encoded;
+      try {
+         encoded.storage = std::make_unique<TextureStorage>(layers, faces, levels, base_dim, format.block_dim(), block_span, alignment);
+      } catch (const std::bad_alloc&) {
+         set_status_(status_conversion_error);
+         log_exception(std::system_error(std::make_error_code(std::errc::not_enough_memory), "Not enough memory to allocate compressed texture"));
+         return Texture();
+      }
 
-   visit_texture_images(result.view, [&](ImageView& img) {
-      std::size_t layer = img.layer();
-      std::size_t face = img.face();
-      std::size_t level = img.level();
+      encoded.view = TextureView(format, tex_class, *encoded.storage, 0, layers, 0, faces, 0, levels);
+      encode_blocks_(result.view, encoded.view);
+      result = std::move(encoded);
+   }
+
+   return result;
+}
 
-      constexpr int layer_bits = 8 * sizeof(TextureStorage::layer_index_type);
-      constexpr int face_bits = 8 * sizeof(TextureStorage::face_index_type);
-      constexpr int level_bits = 8 * sizeof(TextureStorage::level_index_type);
+///////////////////////////////////////////////////////////////////////////////
+struct AtexApp::blit_job_ {
+   ConstImageView src;
+   ImageView dest;
+   ImageRegion region;
+};
 
-      std::size_t img_id = (layer << (face_bits + level_bits)) | (face << level_bits) | level;
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::plan_blits_(TextureView dest, const input_& input, TextureView src, const image_map_& images, std::vector<blit_job_>& jobs) {
+   // Large images are split into bands of rows so that a texture with only a
+   // few big images still keeps every thread busy.  Each band converts the
+   // same pixels the whole-image blit would, so the output is identical.
+   constexpr std::size_t min_band_pixels = 1 << 16;
+
+   for (const input_image_& img : input.images) {
+      if (img.layer >= dest.layers() || img.face >= dest.faces() || img.level >= dest.levels()) {
+         continue;
+      }
 
-      auto it = images.find(img_id);
-      if (it != images.end()) {
+      const image_slot_* slot = images.find(img.layer, img.face, img.level);
+      if (slot && slot->input == &input) {
          // TODO make sure we can do the conversion (eg. not converting to compressed)
 
-         ConstImageView src = it->second.second;
-         ImageRegion region = ImageRegion(pixel_region(src).extents().intersection(pixel_region(img).extents()));
-         blit_pixels(src, region, img, region);
+         ConstImageView src_img = src.image(img.src_layer, img.src_face, img.src_level);
+         ImageView dest_img = dest.image(img.layer, img.face, img.level);
+         auto extents = pixel_region(src_img).extents().intersection(pixel_region(dest_img).extents());
+
+         std::size_t bands = 1;
+         if (src_img.format().block_dim() == ImageFormat::block_dim_type(1) &&
+             dest_img.format().block_dim() == ImageFormat::block_dim_type(1)) {
+            std::size_t pixels = std::size_t(extents.dim.x) * std::size_t(extents.dim.y) * std::size_t(extents.dim.z);
+            bands = std::max<std::size_t>(1, std::min<std::size_t>(extents.dim.y, pixels / min_band_pixels));
+         }
+
+         std::size_t rows = extents.dim.y;
+         for (std::size_t band = 0; band < bands; ++band) {
+            std::size_t first_row = rows * band / bands;
+            std::size_t end_row = rows * (band + 1) / bands;
+            auto band_extents = extents;
+            band_extents.offset.y += I32(first_row);
+            band_extents.dim.y = I32(end_row - first_row);
+            jobs.push_back(blit_job_ { src_img, dest_img, ImageRegion(band_extents) });
+         }
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::run_blits_(const std::vector<blit_job_>& jobs) {
+   job_pool_().run(jobs.size(), [&](std::size_t i) {
+      const blit_job_& job = jobs[i];
+      if (!blit_pixels_fast(job.src, job.dest, job.region)) {
+         blit_pixels(job.src, job.region, job.dest, job.region);
       }
    });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::stream_inputs_(TextureView dest, const std::vector<input_>& inputs, const image_map_& images) {
+   be_verbose() << "Reloading input textures" | default_log();
+
+   std::vector<decoded_input_> results(inputs.size());
+   std::vector<U8> changed(inputs.size());
+   std::vector<U8> decoded_blocks(inputs.size());
+
+   // Each file is decoded, copied into place, and released by a single job, so
+   // at most one decoded input per thread is resident at a time.
+   job_pool_().run(inputs.size(), [&](std::size_t i) {
+      const input_& input = inputs[i];
+      decoded_input_& result = results[i];
+
+      decoded_input_ decoded = read_input_(input.file);
+      result.read_error = decoded.read_error;
+      result.parse_error = decoded.parse_error;
+      if (decoded.read_error || decoded.parse_error || !decoded.texture.view) {
+         return;
+      }
+
+      TextureView view = select_input_view_(input.file, decoded.texture.view);
+      if (view.format() != input.format) {
+         changed[i] = true;
+         return;
+      }
+
+      for (const input_image_& img : input.images) {
+         if (img.src_layer >= view.layers() || img.src_face >= view.faces() || img.src_level >= view.levels() ||
+             view.image(img.src_layer, img.src_face, img.src_level).dim() != img.dim) {
+            changed[i] = true;
+            return;
+         }
+      }
+
+      Texture decoded_texture;
+      if (can_decode_blocks(view.format()) && view.format() != dest.format()) {
+         decoded_texture = decode_blocks_(view);
+         view = decoded_texture.view;
+         decoded_blocks[i] = 1;
+      }
+
+      std::vector<blit_job_> jobs;
+      plan_blits_(dest, input, view, images, jobs);
+      run_blits_(jobs);
+   });
+
+   // Logged here rather than by the jobs so that messages stay in input order
+   for (std::size_t i = 0; i < inputs.size(); ++i) {
+      const Path& path = inputs[i].path;
+      if (decoded_blocks[i]) {
+         be_verbose() << "Decoding compressed blocks"
+            & attr(ids::log_attr_path) << path.string()
+            & attr("Block Packing") << inputs[i].format.packing()
+            | default_log();
+      }
+
+      if (results[i].read_error) {
+         set_status_(status_read_error);
+         log_exception(std::system_error(results[i].read_error, "Failed to read texture file: " + path.string()));
+      } else if (results[i].parse_error) {
+         set_status_(status_read_error);
+         log_exception(std::system_error(results[i].parse_error, "Failed to parse texture file: " + path.string()));
+      } else if (changed[i]) {
+         set_status_(status_read_error);
+         be_error() << "Texture file changed between passes!"
+            & attr(ids::log_attr_path) << path.string()
+            | default_log();
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::generate_mipmaps_(TextureView view, const image_map_& images) {
+   if (is_compressed(view.format().packing())) {
+      set_status_(status_warning);
+      be_warn() << "Mipmaps can't be generated for compressed texel formats!"
+         & attr("Block Packing") << view.format().packing()
+         | default_log();
+      return;
+   }
+
+   be_verbose() << "Generating mipmap levels"
+      & attr("Filter") << mipmap_filter_name(mip_options_.filter)
+      | default_log();
+
+   // Each layer/face is an independent chain of levels, but the levels within
+   // a chain must be generated in order.
+   std::size_t faces = view.faces();
+   job_pool_().run(view.layers() * faces, [&](std::size_t i) {
+      std::size_t layer = i / faces;
+      std::size_t face = i % faces;
+
+      std::vector<U8> provided(view.levels());
+      for (std::size_t level = 0; level < provided.size(); ++level) {
+         const image_slot_* slot = images.find(layer, face, level);
+         provided[level] = slot && slot->input ? 1 : 0;
+      }
+
+      generate_mipmaps(view, layer, face, provided, mip_options_);
+   });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Texture AtexApp::decode_blocks_(TextureView src) {
+   ImageFormat format = block_codec_texel_format(src.format());
+
+   Texture result;
+   result.storage = std::make_unique<TextureStorage>(src.layers(), src.faces(), src.levels(), src.image().dim(),
+                                                     format.block_dim(), format.block_size(), TextureAlignment());
+   result.view = TextureView(format, src.texture_class(), *result.storage, 0, src.layers(), 0, src.faces(), 0, src.levels());
+
+   // Images are split into bands of block rows, as in encode_blocks_()
+   constexpr I32 band_rows = 16;
+
+   struct decode_job {
+      ConstImageView src;
+      ImageView dest;
+      I32 first_row;
+      I32 rows;
+   };
+
+   std::vector<decode_job> jobs;
+   for (std::size_t layer = 0; layer < src.layers(); ++layer) {
+      for (std::size_t face = 0; face < src.faces(); ++face) {
+         for (std::size_t level = 0; level < src.levels(); ++level) {
+            ConstImageView src_img = src.image(layer, face, level);
+            ImageView dest_img = result.view.image(layer, face, level);
+            I32 block_rows = (src_img.dim().y + src_img.format().block_dim().y - 1) / src_img.format().block_dim().y;
+            for (I32 row = 0; row < block_rows; row += band_rows) {
+               jobs.push_back(decode_job { src_img, dest_img, row, std::min(band_rows, block_rows - row) });
+            }
+         }
+      }
+   }
+
+   job_pool_().run(jobs.size(), [&](std::size_t i) {
+      const decode_job& job = jobs[i];
+      decode_block_rows(job.src, job.dest, job.first_row, job.rows);
+   });
 
    return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-void AtexApp::write_outputs_(TextureView view) {
+void AtexApp::encode_blocks_(TextureView src, TextureView dest) {
+   be_verbose() << "Encoding compressed blocks"
+      & attr("Block Packing") << dest.format().packing()
+      & attr("Quality") << encode_quality_name(encode_quality_)
+      | default_log();
+
+   // Images are split into bands of block rows so that a texture with only a
+   // few big images still keeps every thread busy.
+   constexpr I32 band_rows = 16;
+
+   struct encode_job {
+      ConstImageView src;
+      ImageView dest;
+      I32 first_row;
+      I32 rows;
+   };
+
+   std::vector<encode_job> jobs;
+   for (std::size_t layer = 0; layer < dest.layers(); ++layer) {
+      for (std::size_t face = 0; face < dest.faces(); ++face) {
+         for (std::size_t level = 0; level < dest.levels(); ++level) {
+            ConstImageView src_img = src.image(layer, face, level);
+            ImageView dest_img = dest.image(layer, face, level);
+            I32 block_rows = (dest_img.dim().y + dest_img.format().block_dim().y - 1) / dest_img.format().block_dim().y;
+            for (I32 row = 0; row < block_rows; row += band_rows) {
+               jobs.push_back(encode_job { src_img, dest_img, row, std::min(band_rows, block_rows - row) });
+            }
+         }
+      }
+   }
+
+   job_pool_().run(jobs.size(), [&](std::size_t i) {
+      const encode_job& job = jobs[i];
+      encode_block_rows(job.src, job.dest, job.first_row, job.rows, encode_quality_);
+   });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Path> AtexApp::write_outputs_(TextureView view) {
+   std::vector<output_image_> outputs;
+
    for (output_file_ file : output_files_) {
       file.path = fs::absolute(file.path, output_path_base_);
 
@@ -768,22 +1343,24 @@ void AtexApp::write_outputs_(TextureView view) {
          case TextureFileFormat::betx:
          case TextureFileFormat::ktx:
          case TextureFileFormat::dds:
-            write_output_(selected_view, file.path, file.file_format, file.byte_order, file.payload_compression);
+            plan_output_(selected_view, file, -1, outputs);
             break;
 
          default:
             // image files don't support multiple layers/faces/levels
-            write_layer_images_(selected_view, file);
+            plan_layer_images_(selected_view, file, outputs);
             break;
       }
    }
+
+   return run_outputs_(outputs);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-void AtexApp::write_layer_images_(TextureView view, output_file_ file) {
+void AtexApp::plan_layer_images_(TextureView view, output_file_ file, std::vector<output_image_>& outputs) {
 
    if (view.layers() <= 1) {
-      write_face_images_(view, std::move(file));
+      plan_face_images_(view, std::move(file), outputs);
    } else {
       Path parent_path = file.path.parent_path();
       S base = file.path.stem().string() + "-layer";
@@ -796,15 +1373,15 @@ void AtexApp::write_layer_images_(TextureView view, output_file_ file) {
                                               layer, 1,
                                               view.base_face(), view.faces(),
                                               view.base_level(), view.levels());
-         write_face_images_(layer_view, file);
+         plan_face_images_(layer_view, file, outputs);
       }
    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-void AtexApp::write_face_images_(TextureView view, output_file_ file) {
+void AtexApp::plan_face_images_(TextureView view, output_file_ file, std::vector<output_image_>& outputs) {
    if (view.faces() <= 1) {
-      write_level_images_(view, std::move(file));
+      plan_level_images_(view, std::move(file), outputs);
    } else {
       Path parent_path = file.path.parent_path();
       S base = file.path.stem().string() + "-face";
@@ -817,15 +1394,15 @@ void AtexApp::write_face_images_(TextureView view, output_file_ file) {
                                              view.base_layer(), view.layers(),
                                              face, 1,
                                              view.base_level(), view.levels());
-         write_level_images_(face_view, file);
+         plan_level_images_(face_view, file, outputs);
       }
    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-void AtexApp::write_level_images_(TextureView view, output_file_ file) {
+void AtexApp::plan_level_images_(TextureView view, output_file_ file, std::vector<output_image_>& outputs) {
    if (view.levels() <= 1) {
-      write_plane_images_(view, std::move(file));
+      plan_plane_images_(view, std::move(file), outputs);
    } else {
       Path parent_path = file.path.parent_path();
       S base = file.path.stem().string() + "-level";
@@ -838,16 +1415,16 @@ void AtexApp::write_level_images_(TextureView view, output_file_ file) {
                                               view.base_layer(), view.layers(),
                                               view.base_face(), view.faces(),
                                               level, 1);
-         write_plane_images_(level_view, file);
+         plan_plane_images_(level_view, file, outputs);
       }
    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-void AtexApp::write_plane_images_(TextureView view, output_file_ file) {
+void AtexApp::plan_plane_images_(TextureView view, output_file_ file, std::vector<output_image_>& outputs) {
    I32 depth = view.image().dim().z;
    if (depth <= 1) {
-      write_output_(view, file.path, file.file_format, file.byte_order, file.payload_compression, 0);
+      plan_output_(view, file, 0, outputs);
    } else {
       Path parent_path = file.path.parent_path();
       S base = file.path.stem().string() + "-z";
@@ -855,27 +1432,96 @@ void AtexApp::write_plane_images_(TextureView view, output_file_ file) {
 
       for (I32 z = 0; z < depth; ++z) {
          file.path = parent_path / Path(base + std::to_string((std::size_t)z) + ext);
-         write_output_(view, file.path, file.file_format, file.byte_order, file.payload_compression, z);
+         plan_output_(view, file, z, outputs);
       }
    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-void AtexApp::write_output_(TextureView view, const Path& path, TextureFileFormat format, ByteOrderType byte_order, bool payload_compression, I32 depth) {
-   std::error_code ec;
+void AtexApp::plan_output_(TextureView view, const output_file_& file, I32 depth, std::vector<output_image_>& outputs) {
+   output_image_ output;
+   output.view = view;
+   output.path = file.path;
+   output.file_format = file.file_format;
+   output.byte_order = file.byte_order;
+   output.payload_compression = file.payload_compression;
+   output.depth = depth;
+   outputs.push_back(std::move(output));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Path> AtexApp::run_outputs_(std::vector<output_image_>& outputs) {
+   // Outputs that share a path are written by the same job, in order, so the
+   // last one wins just as it would when writing serially.  Without
+   // --overwrite, only the first of them is written.
+   std::vector<std::vector<std::size_t>> jobs;
+   std::unordered_map<S, std::size_t> path_jobs;
+   for (std::size_t i = 0; i < outputs.size(); ++i) {
+      output_image_& output = outputs[i];
+      auto result = path_jobs.emplace(output.path.string(), jobs.size());
+      if (!overwrite_output_files_ && (!result.second || fs::exists(output.path))) {
+         output.already_exists = true;
+         continue;
+      }
+      if (result.second) {
+         jobs.emplace_back();
+      }
+      jobs[result.first->second].push_back(i);
+   }
 
-   be_short_info() << "Writing " << format << " texture file: " << path.string() | default_log();
+   // Writers don't log or touch status_, so any number of files can be
+   // encoded at once; results are reported afterwards in the order the
+   // outputs were planned.  Existing files are unlinked rather than
+   // truncated, since they may be hard links into a --cache-dir entry.
+   job_pool_().run(jobs.size(), [&](std::size_t i) {
+      std::error_code ec;
+      fs::remove(outputs[jobs[i].front()].path, ec);
+      for (std::size_t index : jobs[i]) {
+         outputs[index].ec = write_output_(outputs[index]);
+      }
+   });
 
-   
-      if (fs::exists(path) && !overwrite_output_files_) {
+   std::vector<Path> written;
+   for (const std::vector<std::size_t>& job : jobs) {
+      if (!outputs[job.back()].ec) {
+         written.push_back(outputs[job.back()].path);
+      }
+   }
+
+   for (const output_image_& output : outputs) {
+      be_short_info() << "Writing " << output.file_format << " texture file: " << output.path.string() | default_log();
+
+      if (output.already_exists) {
          set_status_(status_write_error);
          be_error() << "Skipping ouput file: file already exists; use --overwrite to ignore."
-            & attr(ids::log_attr_output_path) << path.string()
+            & attr(ids::log_attr_output_path) << output.path.string()
             | default_log();
-         return;
+      } else if (output.ec) {
+         set_status_(status_write_error);
+         log_exception(fs::filesystem_error("Error writing output texture!", output.path, output.ec));
       }
+   }
+   return written;
+}
 
-   switch (format) {
+///////////////////////////////////////////////////////////////////////////////
+std::error_code AtexApp::write_output_(const output_image_& output) const {
+   std::error_code ec;
+   const TextureView& view = output.view;
+   const Path& path = output.path;
+   ByteOrderType byte_order = output.byte_order;
+   bool payload_compression = output.payload_compression;
+   I32 depth = output.depth;
+
+   Profiler::Scope scope(profiler_.get(), "Write", path.string());
+   if (depth < 0) {
+      scope.pixels(texture_pixels(view));
+   } else {
+      ivec3 dim = view.image().dim();
+      scope.pixels(U64(dim.x) * dim.y);
+   }
+
+   switch (output.file_format) {
       case TextureFileFormat::betx:
       {
          BetxWriter writer;
@@ -893,6 +1539,13 @@ void AtexApp::write_output_(TextureView view, const Path& path, TextureFileForma
          writer.write(path, ec);
          break;
       }
+      case TextureFileFormat::dds:
+      {
+         DdsWriter writer;
+         writer.texture(view);
+         writer.write(path, ec);
+         break;
+      }
       case TextureFileFormat::png:
       {
          PngWriter writer;
@@ -930,16 +1583,16 @@ void AtexApp::write_output_(TextureView view, const Path& path, TextureFileForma
          writer.write(path, ec);
          break;
       }
-      case TextureFileFormat::dds:
-         // TODO
       default:
          ec = std::make_error_code(std::errc::not_supported);
          break;
    }
-   if (ec) {
-      set_status_(status_write_error);
-      log_exception(fs::filesystem_error("Error writing output texture!", path, ec));
+   if (!ec) {
+      std::error_code size_ec;
+      U64 size = fs::file_size(path, size_ec);
+      scope.bytes_written(size_ec ? 0 : size);
    }
+   return ec;
 }
 
 } // be::atex
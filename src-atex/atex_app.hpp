@@ -2,6 +2,12 @@
 #ifndef BE_ATEX_ATEX_APP_HPP_
 #define BE_ATEX_ATEX_APP_HPP_
 
+#include "block_decoder.hpp"
+#include "block_encoder.hpp"
+#include "image_slot_table.hpp"
+#include "mipmap_generator.hpp"
+#include "profiler.hpp"
+#include "../src-common/job_pool.hpp"
 #include <be/core/lifecycle.hpp>
 #include <be/core/filesystem.hpp>
 #include <be/gfx/tex/texture.hpp>
@@ -9,12 +15,10 @@
 #include <be/core/glm.hpp>
 #include <be/core/byte_order.hpp>
 
-// TODO ktx, dds, glraw read/write
+// TODO ktx, glraw read/write
+// TODO dds read
 // TODO stbiw png, tga, hdr, bmp write
 // TODO libpng read/write
-// TODO S3TC decoding
-// TODO RGTC decoding
-// TODO BPTC decoding
 
 namespace be::atex {
 
@@ -68,14 +72,40 @@ private:
       bool override_premultiplied = false;
       bool premultiplied = false;
    };
+   struct decoded_input_ {
+      gfx::tex::TextureFileFormat file_format = gfx::tex::TextureFileFormat::unknown;
+      gfx::tex::Texture texture;
+      std::error_code read_error;
+      std::error_code parse_error;
+   };
+   struct input_image_ {
+      gfx::tex::TextureStorage::layer_index_type src_layer = 0;
+      gfx::tex::TextureStorage::face_index_type src_face = 0;
+      gfx::tex::TextureStorage::level_index_type src_level = 0;
+      gfx::tex::TextureStorage::layer_index_type layer = 0;
+      gfx::tex::TextureStorage::face_index_type face = 0;
+      gfx::tex::TextureStorage::level_index_type level = 0;
+      ivec3 dim;
+   };
    struct input_ {
       Path path;
+      input_file_ file;
       gfx::tex::TextureFileFormat file_format = gfx::tex::TextureFileFormat::unknown;
-      gfx::tex::Texture texture;
+      gfx::tex::Texture texture; // view may select a subset of storage; empty after loading when using two-pass merging
+      gfx::tex::ImageFormat format;
+      gfx::tex::TextureClass texture_class = gfx::tex::TextureClass::planar;
+      U8 block_span = 0;
+      gfx::tex::TextureAlignment alignment;
       gfx::tex::TextureStorage::layer_index_type dest_layer = gfx::tex::TextureStorage::max_layers;
       gfx::tex::TextureStorage::face_index_type dest_face = gfx::tex::TextureStorage::max_faces;
       gfx::tex::TextureStorage::level_index_type dest_level = gfx::tex::TextureStorage::max_levels;
+      std::vector<input_image_> images;
+   };
+   struct image_slot_ {
+      const input_* input = nullptr;
+      const input_image_* image = nullptr;
    };
+   using image_map_ = ImageSlotTable<image_slot_>;
 
    struct output_file_ {
       using layer_index_type = gfx::tex::TextureStorage::layer_index_type;
@@ -100,22 +130,72 @@ private:
       ByteOrderType byte_order = bo::Host::value;
       bool payload_compression = false;
    };
+   struct output_image_ {
+      gfx::tex::TextureView view;
+      Path path;
+      gfx::tex::TextureFileFormat file_format = gfx::tex::TextureFileFormat::unknown;
+      ByteOrderType byte_order = bo::Host::value;
+      bool payload_compression = false;
+      I32 depth = -1;
+      bool already_exists = false;
+      std::error_code ec;
+   };
 
    void set_status_(status_code_ status);
 
+   tools::JobPool& job_pool_();
+
+   void convert_();
+   void report_profile_();
+
+   std::unique_ptr<AtexApp> make_job_app_(std::vector<S>& args);
+   void run_batch_();
+   void run_server_();
+
+   S cache_key_();
+   bool restore_cached_outputs_(const S& key);
+   void store_cached_outputs_(const S& key, const std::vector<Path>& outputs);
+
    std::vector<input_> load_inputs_();
-   input_ load_input_(const input_file_& file);
-   gfx::tex::Texture make_texture_(const std::vector<input_>& inputs);
-   void write_outputs_(gfx::tex::TextureView view);
-   void write_layer_images_(gfx::tex::TextureView view, output_file_ file);
-   void write_face_images_(gfx::tex::TextureView view, output_file_ file);
-   void write_level_images_(gfx::tex::TextureView view, output_file_ file);
-   void write_plane_images_(gfx::tex::TextureView view, output_file_ file);
-   void write_output_(gfx::tex::TextureView view, const Path& path, gfx::tex::TextureFileFormat format, ByteOrderType byte_order, bool payload_compression, I32 depth = -1);
+   decoded_input_ read_input_(const input_file_& file) const;
+   input_ load_input_(const input_file_& file, decoded_input_ decoded);
+   static gfx::tex::TextureView select_input_view_(const input_file_& file, gfx::tex::TextureView view);
+   gfx::tex::Texture make_texture_(std::vector<input_>& inputs);
+   struct blit_job_;
+   static void plan_blits_(gfx::tex::TextureView dest, const input_& input, gfx::tex::TextureView src, const image_map_& images, std::vector<blit_job_>& jobs);
+   void run_blits_(const std::vector<blit_job_>& jobs);
+   void stream_inputs_(gfx::tex::TextureView dest, const std::vector<input_>& inputs, const image_map_& images);
+   void generate_mipmaps_(gfx::tex::TextureView view, const image_map_& images);
+   gfx::tex::Texture decode_blocks_(gfx::tex::TextureView src);
+   void encode_blocks_(gfx::tex::TextureView src, gfx::tex::TextureView dest);
+   std::vector<Path> write_outputs_(gfx::tex::TextureView view);
+   static void plan_layer_images_(gfx::tex::TextureView view, output_file_ file, std::vector<output_image_>& outputs);
+   static void plan_face_images_(gfx::tex::TextureView view, output_file_ file, std::vector<output_image_>& outputs);
+   static void plan_level_images_(gfx::tex::TextureView view, output_file_ file, std::vector<output_image_>& outputs);
+   static void plan_plane_images_(gfx::tex::TextureView view, output_file_ file, std::vector<output_image_>& outputs);
+   static void plan_output_(gfx::tex::TextureView view, const output_file_& file, I32 depth, std::vector<output_image_>& outputs);
+   std::vector<Path> run_outputs_(std::vector<output_image_>& outputs);
+   std::error_code write_output_(const output_image_& output) const;
 
    CoreInitLifecycle init_;
    I8 status_ = 0;
 
+   U32 jobs_ = 0;
+   std::unique_ptr<tools::JobPool> job_pool_ptr_;
+   tools::JobPool* shared_job_pool_ = nullptr; // set for jobs run by --batch
+   bool two_pass_merge_ = false;
+
+   S batch_manifest_;
+   S server_socket_path_;
+
+   std::vector<S> command_line_;
+   Path cache_dir_;
+
+   bool profile_ = false;
+   S profile_json_path_;
+   S profile_trace_path_;
+   std::unique_ptr<Profiler> profiler_;
+
    std::vector<Path> input_search_paths_;
    std::vector<input_file_> input_files_;
 
@@ -142,6 +222,11 @@ private:
    bool override_tex_class_ = false;
    gfx::tex::TextureClass tex_class_;
 
+   bool generate_mips_ = false;
+   MipmapOptions mip_options_;
+
+   EncodeQuality encode_quality_ = EncodeQuality::normal;
+
    Path output_path_base_;
    std::vector<output_file_> output_files_;
    bool overwrite_output_files_ = false;
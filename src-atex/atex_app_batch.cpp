@@ -0,0 +1,50 @@
+#include "atex_app.hpp"
+#include "../src-common/batch.hpp"
+#include "../src-common/command_line.hpp"
+#include <be/core/log_exception.hpp>
+#include <be/core/logging.hpp>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+std::unique_ptr<AtexApp> AtexApp::make_job_app_(std::vector<S>& args) {
+   std::vector<char*> argv = tools::make_argv("atex", args);
+   auto app = std::make_unique<AtexApp>(int(argv.size() - 1), argv.data());
+   app->shared_job_pool_ = &job_pool_();
+
+   // Jobs run on the pool of the batch or server that created them, so a
+   // nested batch would tie up that pool and a nested server would never
+   // return.
+   if (!app->batch_manifest_.empty() || !app->server_socket_path_.empty()) {
+      app->set_status_(status_cli_error);
+      be_error() << "--batch and --serve can't be used within a batch manifest or server request!" | default_log();
+   }
+
+   return app;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::run_batch_() {
+   std::vector<tools::BatchLine> lines;
+   try {
+      lines = tools::read_batch_manifest(batch_manifest_);
+   } catch (const fs::filesystem_error& e) {
+      set_status_(status_read_error);
+      log_exception(e);
+      return;
+   }
+
+   be_verbose() << "Running batch"
+      & attr("Manifest") << batch_manifest_
+      & attr("Jobs") << lines.size()
+      | default_log();
+
+   // Each job runs on a single thread of this app's pool; any parallel work
+   // inside a job is run serially since the pool is already busy.
+   int status = tools::run_batch(lines, job_pool_(), [this](std::vector<S>& args) {
+      return make_job_app_(args);
+   });
+   set_status_(static_cast<status_code_>(status));
+}
+
+} // be::atex
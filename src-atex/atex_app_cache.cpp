@@ -0,0 +1,183 @@
+#include "atex_app.hpp"
+#include "content_hash.hpp"
+#include "version.hpp"
+#include <be/core/log_exception.hpp>
+#include <be/core/logging.hpp>
+#include <be/util/paths.hpp>
+#include <be/util/path_glob.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace be::atex {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+void hash_string(ContentHash& hash, const S& str) {
+   U64 size = str.size();
+   hash.update(&size, sizeof(size));
+   hash.update(str.data(), str.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool hash_file(ContentHash& hash, const Path& path) {
+   std::ifstream ifs(path.string(), std::ios::in | std::ios::binary);
+   if (!ifs) {
+      return false;
+   }
+
+   std::vector<char> buf(1 << 16);
+   while (ifs) {
+      ifs.read(buf.data(), std::streamsize(buf.size()));
+      hash.update(buf.data(), std::size_t(ifs.gcount()));
+   }
+   return !ifs.bad();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void link_or_copy(const Path& from, const Path& to, std::error_code& ec) {
+   fs::create_hard_link(from, to, ec);
+   if (ec) {
+      ec.clear();
+      fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec);
+   }
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+S AtexApp::cache_key_() {
+   std::vector<Path> paths;
+   for (const input_file_& file : input_files_) {
+      std::vector<Path> matches = util::glob(file.path.string(), input_search_paths_, util::PathMatchType::files_and_misc);
+      paths.insert(paths.end(), matches.begin(), matches.end());
+   }
+
+   std::vector<U64> digests(paths.size());
+   std::vector<U8> readable(paths.size());
+   job_pool_().run(paths.size(), [&](std::size_t i) {
+      ContentHash hash;
+      readable[i] = hash_file(hash, paths[i]);
+      digests[i] = hash.digest();
+   });
+
+   ContentHash hash;
+   hash_string(hash, std::to_string(BE_ATEX_VERSION));
+   hash_string(hash, util::cwd().string());
+   hash_string(hash, output_path_base_.string());
+   for (const S& arg : command_line_) {
+      hash_string(hash, arg);
+   }
+   for (std::size_t i = 0; i < paths.size(); ++i) {
+      if (!readable[i]) {
+         // let the normal loading process report the problem
+         return S();
+      }
+      hash_string(hash, paths[i].string());
+      hash.update(&digests[i], sizeof(U64));
+   }
+
+   char key[17];
+   std::snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash.digest());
+   return key;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool AtexApp::restore_cached_outputs_(const S& key) {
+   Path entry = cache_dir_ / key;
+   std::ifstream manifest((entry / "manifest").string());
+   if (!manifest) {
+      be_short_verbose() << "Cache miss: " << key | default_log();
+      return false;
+   }
+
+   int cached_status = 0;
+   manifest >> cached_status;
+
+   struct cached_output {
+      Path file;
+      Path path;
+   };
+
+   std::vector<cached_output> outputs;
+   S index;
+   S path;
+   while (manifest >> index && manifest.get() == '\t' && std::getline(manifest, path)) {
+      outputs.push_back(cached_output { entry / index, path });
+      std::error_code ec;
+      if (!fs::is_regular_file(outputs.back().file, ec)) {
+         be_short_verbose() << "Cache entry incomplete: " << key | default_log();
+         return false;
+      }
+   }
+
+   be_short_verbose() << "Cache hit: " << key | default_log();
+
+   for (const cached_output& output : outputs) {
+      be_short_info() << "Restoring cached output file: " << output.path.string() | default_log();
+
+      std::error_code ec;
+      if (fs::exists(output.path, ec)) {
+         if (!overwrite_output_files_) {
+            set_status_(status_write_error);
+            be_error() << "Skipping ouput file: file already exists; use --overwrite to ignore."
+               & attr(ids::log_attr_output_path) << output.path.string()
+               | default_log();
+            continue;
+         }
+         fs::remove(output.path, ec);
+      }
+
+      link_or_copy(output.file, output.path, ec);
+      if (ec) {
+         set_status_(status_write_error);
+         log_exception(fs::filesystem_error("Error writing output texture!", output.path, ec));
+      }
+   }
+
+   set_status_(static_cast<status_code_>(cached_status));
+   return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::store_cached_outputs_(const S& key, const std::vector<Path>& outputs) {
+   std::error_code ec;
+   Path entry = cache_dir_ / key;
+   if (fs::exists(entry, ec)) {
+      return;
+   }
+
+   // Entries are assembled under a unique name and then renamed into place,
+   // so concurrent atex processes never see a partial entry.
+   U64 unique = U64(std::chrono::steady_clock::now().time_since_epoch().count()) ^ U64(std::hash<std::thread::id>()(std::this_thread::get_id()));
+   Path temp = cache_dir_ / (key + ".tmp" + std::to_string(unique));
+   fs::create_directories(temp, ec);
+
+   if (!ec) {
+      std::ofstream manifest((temp / "manifest").string(), std::ios::out | std::ios::trunc);
+      manifest << int(status_) << '\n';
+      for (std::size_t i = 0; i < outputs.size() && !ec; ++i) {
+         link_or_copy(outputs[i], temp / std::to_string(i), ec);
+         manifest << i << '\t' << outputs[i].string() << '\n';
+      }
+      manifest.close();
+      if (!ec && !manifest) {
+         ec = std::make_error_code(std::errc::io_error);
+      }
+   }
+
+   if (!ec) {
+      fs::rename(temp, entry, ec);
+   }
+
+   if (ec) {
+      be_short_verbose() << "Failed to store cache entry: " << key | default_log();
+      std::error_code ignored;
+      fs::remove_all(temp, ignored);
+   } else {
+      be_short_verbose() << "Stored cache entry: " << key | default_log();
+   }
+}
+
+} // be::atex
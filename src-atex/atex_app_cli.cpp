@@ -1,4 +1,5 @@
 #include "atex_app.hpp"
+#include "block_codec.hpp"
 #include "version.hpp"
 #include <be/gfx/version.hpp>
 #include <be/core/version.hpp>
@@ -11,7 +12,8 @@
 namespace be::atex {
 
 ///////////////////////////////////////////////////////////////////////////////
-AtexApp::AtexApp(int argc, char** argv) {
+AtexApp::AtexApp(int argc, char** argv)
+   : command_line_(argv + (argc > 0 ? 1 : 0), argv + argc) {
    default_log().verbosity_mask(v::info_or_worse);
    try {
       using namespace cli;
@@ -47,10 +49,11 @@ AtexApp::AtexApp(int argc, char** argv) {
          (summary ("Execution consists of two phases.  First, one or more input images or textures are loaded.  In the second phase, each input image/texture is "
                    "copied into a single in-memory texture, converting the texel format if necessary.  Then one or more image or texture views are written to disk.").verbose())
 
-         (summary ("Although texel format, colorspace, alpha premultiplication, and channel swizzling conversions can be performed on textures, no other operations will be performed, including "
-                   "rescaling, cropping, mipmap generation, rotation, distortion, compositing, exposure/color correction, etc.  Compressed texel formats can be converted to uncompressed texel "
-                   "formats, but compressed texel formats can only be output if the input textures are provided in the exact same compressed texel format and no colorspace or alpha "
-                   "premultiplication conversions are required.").verbose())
+         (summary ("Although texel format, colorspace, alpha premultiplication, and channel swizzling conversions can be performed on textures, and missing mipmap levels "
+                   "can be generated, no other operations will be performed, including rescaling, cropping, rotation, distortion, compositing, exposure/color correction, "
+                   "etc.  Compressed texel formats can be converted to uncompressed texel formats.  S3TC, RGTC, and BPTC texel formats can also be output from any input "
+                   "texel format; other compressed texel formats can only be output if the input textures are provided in the exact same compressed texel format and no "
+                   "colorspace or alpha premultiplication conversions are required.").verbose())
 
          (summary (Cell() << "If any input texture field types or swizzles are reinterpreted with " << fg_yellow << "--ctype-*" << reset << " or " << fg_yellow
                           << "--swizzle-*" << reset << " then they are all reinterpreted.  Field types will default to " << fg_cyan << "none" << reset
@@ -74,7 +77,7 @@ AtexApp::AtexApp(int argc, char** argv) {
                           << fg_dark_gray << ", " << fg_green << "GIF").verbose())
 
          (summary (Cell() << "Supported output texture file types: " << fg_green << "beTx"
-                          //<< fg_dark_gray << ", " << fg_green << "DDS"
+                          << fg_dark_gray << ", " << fg_green << "DDS"
                           << fg_dark_gray << ", " << fg_green << "KTX").verbose())
          (summary (Cell() << "Supported output image file types: " << fg_green << "PNG"
                           << fg_dark_gray << ", " << fg_green << "Targa"
@@ -204,12 +207,13 @@ AtexApp::AtexApp(int argc, char** argv) {
             }).when(configuring_output).desc("Specifies the texture class for output textures."))
 
          (enum_param<BlockPacking> ({ "p" }, { "packing" }, "PACKING", packing_, [](BlockPacking packing) {
-               return !is_compressed(packing);
+               return !is_compressed(packing) || is_block_codec_packing(packing);
             }, [this](BlockPacking packing) {
                override_block_ = true;
                return packing;
             }).when(configuring_output)
-              .desc("Specifies that output textures should use a custom texel format and sets the block packing for that format."))
+              .desc("Specifies that output textures should use a custom texel format and sets the block packing for that format.")
+              .extra("S3TC, RGTC, and BPTC packings will be encoded using 4x4 blocks.  For BPTC, a first field type of ufloat or sfloat selects BC6H; otherwise BC7 is used."))
 
          (numeric_param ({ "c" }, { "components" }, "N", components_, (U8)1, (U8)4)
             .when(configuring_output).desc("Specifies the number of components when using a custom texel format."))
@@ -259,6 +263,33 @@ AtexApp::AtexApp(int argc, char** argv) {
                override_premultiplied_ = true;
             }).when(configuring_output).desc("Output textures should not be premultiplied."))
 
+         (flag ({ }, { "generate-mips" }, generate_mips_).when(configuring_output)
+            .desc("Generates any missing mipmap levels below the lowest level provided by the input textures.")
+            .extra(Cell() << "A full mipmap chain will be created.  Levels which are provided by an input texture are used as-is, and following levels will be "
+                             "filtered from them.  Filtering is done in linear space, with alpha premultiplied for color images.  Compressed texel formats are only "
+                             "supported if they can be encoded."))
+
+         (param ({ }, { "mip-filter" }, "FILTER", [this](const S& str) {
+               if (!parse_mipmap_filter(str, mip_options_.filter)) {
+                  throw std::runtime_error("Unrecognized mipmap filter: " + str);
+               }
+            }).when(configuring_output).desc("Specifies the filter used by --generate-mips.")
+              .extra(Cell() << "Must be one of " << fg_cyan << "box" << reset << ", " << fg_cyan << "kaiser" << reset << ", or " << fg_cyan << "lanczos"
+                            << reset << ".  Defaults to " << fg_cyan << "box" << reset << "."))
+
+         (numeric_param<F32> ({ }, { "mip-alpha-coverage" }, "REF", mip_options_.alpha_reference, 0.f, 1.f).when(configuring_output)
+            .desc("Scales the alpha channel of generated mipmap levels to preserve the fraction of texels whose alpha is greater than the reference value.")
+            .extra("Useful for alpha-tested textures, which otherwise tend to become more transparent in distant mipmap levels."))
+         (flag ({ }, { "mip-alpha-coverage" }, mip_options_.preserve_alpha_coverage).when(configuring_output))
+
+         (param ({ }, { "bc-quality" }, "QUALITY", [this](const S& str) {
+               if (!parse_encode_quality(str, encode_quality_)) {
+                  throw std::runtime_error("Unrecognized block compression quality: " + str);
+               }
+            }).when(configuring_output).desc("Specifies the effort spent searching for endpoints when encoding S3TC, RGTC, or BPTC blocks.")
+              .extra(Cell() << "Must be one of " << fg_cyan << "fast" << reset << ", " << fg_cyan << "normal" << reset << ", or " << fg_cyan << "best"
+                            << reset << ".  Defaults to " << fg_cyan << "normal" << reset << "."))
+
          (numeric_param<U8> ({ }, { "line-align" }, "BITS", line_alignment_bits_, 0, TextureAlignment::max_alignment_bits).when(configuring_output)
             .desc("Specifies the minimum alignment of each line."))
          (numeric_param<U8> ({ }, { "plane-align" }, "BITS", plane_alignment_bits_, 0, TextureAlignment::max_alignment_bits).when(configuring_output)
@@ -383,6 +414,55 @@ AtexApp::AtexApp(int argc, char** argv) {
             .desc("Specifies the quality level to use when writing JPEG files.")
             .extra("Applies to all output JPEG files.  If set multiple times, only the last specified value is meaningful."))
 
+         (numeric_param<U32> ({ "j" }, { "jobs" }, "N", jobs_, 0, 1024)
+            .desc("Specifies the maximum number of threads to use.")
+            .extra("If set to 0, one thread will be used for each hardware thread available.  Input files are decoded concurrently and texel format conversion "
+                   "is split across images and bands of rows, but warnings and conflicts between inputs are always reported in the order the inputs were specified, "
+                   "and the output is identical regardless of the number of threads used."))
+
+         (param ({ }, { "batch" }, "MANIFEST", [&](const S& str) {
+               batch_manifest_ = str;
+            }).desc("Runs each line of a manifest file as a separate atex command line.")
+              .extra(Cell() << nl << "If " << fg_cyan << "MANIFEST" << reset << " is " << fg_cyan << "-" << reset << ", command lines are read from standard input.  "
+                               "Arguments are separated by whitespace and may be quoted with ' or \".  Blank lines and lines starting with # are ignored.  Jobs are "
+                               "run concurrently, up to the limit set by " << fg_yellow << "--jobs" << reset << ", but each job only uses one thread.  Each job's log output is held "
+                               "and written as one block, labeled with its manifest line, in manifest order.  Once all jobs "
+                               "finish, one line is written to standard output for each job, containing the manifest line number and the job's exit code, separated by a tab.  "
+                               "The batch's exit code is the highest exit code of any job.  No input or output files may be specified alongside this option, and manifest lines "
+                               "can't use " << fg_yellow << "--batch" << reset << " or " << fg_yellow << "--serve" << reset << "."))
+
+         (param ({ }, { "serve" }, "SOCKET", [&](const S& str) {
+               server_socket_path_ = str;
+            }).desc("Listens on a local (Unix domain) socket and runs each line received as a separate atex command line.")
+              .extra(Cell() << nl << "Command lines use the same syntax as " << fg_yellow << "--batch" << reset << " manifests.  Requests are run one at a time in "
+                               "this process, reusing its worker threads.  After each request finishes, a line is sent back containing the request's exit code and its "
+                               "duration in microseconds, separated by a tab.  Requests can't use " << fg_yellow << "--batch" << reset << " or " << fg_yellow << "--serve" << reset
+                            << ".  The server stops, removing the socket file, when it receives a request consisting only of " << fg_yellow << "--quit" << reset
+                            << ", or on SIGINT or SIGTERM.  No input or output files may be specified alongside this option."))
+
+         (param ({ }, { "cache-dir" }, "PATH", [&](const S& str) {
+               cache_dir_ = util::parse_path(str);
+            }).desc("Enables caching of output files in the specified directory.")
+              .extra(Cell() << nl << "Outputs are cached under a hash of the contents and paths of all input files, the command line, and the working directory.  "
+                               "When a matching entry exists, the outputs are restored from the cache (using hard links where possible) without reading any inputs.  "
+                               "Runs which produce errors are not cached."))
+
+         (flag ({ }, { "profile" }, profile_)
+            .desc("Logs the wall time, CPU time, bytes read and written, pixels processed, and peak memory usage of each phase.")
+            .extra("Timings for each file read or written are also logged at verbose level."))
+         (param ({ }, { "profile-json" }, "PATH", [&](const S& str) {
+               profile_json_path_ = str;
+            }).desc("Writes the timing information collected by --profile to a JSON file."))
+         (param ({ }, { "profile-trace" }, "PATH", [&](const S& str) {
+               profile_trace_path_ = str;
+            }).desc("Writes the timing information collected by --profile in Chrome's trace event format.")
+              .extra("The trace can be loaded in chrome://tracing or Perfetto to see how files were scheduled across threads."))
+
+         (flag ({ }, { "two-pass" }, two_pass_merge_)
+            .desc("Reads each input file twice to reduce peak memory usage.")
+            .extra("The first pass only records the layout and texel format of each input.  In the second pass each input is decoded again, copied directly into "
+                   "the in-memory texture, and then discarded, so at most one decoded input per thread is kept in memory at once."))
+
          (verbosity_param ({ "v" },{ "verbosity" }, "LEVEL", default_log().verbosity_mask()))
 
          (flag ({ "V" },{ "version" }, show_version).desc("Prints version information to standard output."))
@@ -420,7 +500,19 @@ AtexApp::AtexApp(int argc, char** argv) {
 
       proc.process(argc, argv);
 
-      if (!show_help && !show_version && input_files_.empty()) {
+      if (!batch_manifest_.empty() && !server_socket_path_.empty()) {
+         throw std::runtime_error("--batch and --serve can't be used together");
+      }
+
+      if (!batch_manifest_.empty() && (!input_files_.empty() || !output_files_.empty())) {
+         throw std::runtime_error("Input and output files can't be specified when using --batch");
+      }
+
+      if (!server_socket_path_.empty() && (!input_files_.empty() || !output_files_.empty())) {
+         throw std::runtime_error("Input and output files can't be specified when using --serve");
+      }
+
+      if (!show_help && !show_version && input_files_.empty() && batch_manifest_.empty() && server_socket_path_.empty()) {
          show_help = true;
          show_version = true;
          set_status_(status_no_input);
@@ -0,0 +1,242 @@
+#include "atex_app.hpp"
+#include "../src-common/command_line.hpp"
+#include <be/core/log_exception.hpp>
+#include <be/core/logging.hpp>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#else
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace be::atex {
+namespace {
+
+#ifdef _WIN32
+using socket_type = SOCKET;
+const socket_type invalid_socket = INVALID_SOCKET;
+
+std::error_code last_socket_error() {
+   return std::error_code(WSAGetLastError(), std::system_category());
+}
+
+void close_socket(socket_type s) {
+   closesocket(s);
+}
+#else
+using socket_type = int;
+const socket_type invalid_socket = -1;
+
+std::error_code last_socket_error() {
+   return std::error_code(errno, std::generic_category());
+}
+
+void close_socket(socket_type s) {
+   ::close(s);
+}
+#endif
+
+// Set by SIGINT/SIGTERM; the accept loop then stops and cleans up.
+volatile std::sig_atomic_t stop_requested = 0;
+std::atomic<socket_type> active_listener = invalid_socket;
+
+///////////////////////////////////////////////////////////////////////////////
+extern "C" void handle_stop_signal(int) {
+   stop_requested = 1;
+#ifdef _WIN32
+   // Console signal handlers run on their own thread, and don't interrupt
+   // accept(), so the listening socket is closed to wake the server.
+   socket_type listener = active_listener.exchange(invalid_socket);
+   if (listener != invalid_socket) {
+      close_socket(listener);
+   }
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void install_stop_handlers() {
+   stop_requested = 0;
+#ifdef _WIN32
+   std::signal(SIGINT, handle_stop_signal);
+   std::signal(SIGTERM, handle_stop_signal);
+#else
+   // No SA_RESTART, so a blocked accept() or recv() returns EINTR
+   struct sigaction action;
+   std::memset(&action, 0, sizeof(action));
+   action.sa_handler = handle_stop_signal;
+   sigemptyset(&action.sa_mask);
+   sigaction(SIGINT, &action, nullptr);
+   sigaction(SIGTERM, &action, nullptr);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void remove_stop_handlers() {
+   std::signal(SIGINT, SIG_DFL);
+   std::signal(SIGTERM, SIG_DFL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool send_all(socket_type s, const S& data) {
+   int flags = 0;
+#ifdef MSG_NOSIGNAL
+   flags = MSG_NOSIGNAL;
+#endif
+   std::size_t sent = 0;
+   while (sent < data.size()) {
+      auto result = send(s, data.data() + sent, int(data.size() - sent), flags);
+      if (result <= 0) {
+         return false;
+      }
+      sent += std::size_t(result);
+   }
+   return true;
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+void AtexApp::run_server_() {
+#ifdef _WIN32
+   WSADATA wsa_data;
+   if (int result = WSAStartup(MAKEWORD(2, 2), &wsa_data)) {
+      set_status_(status_exception);
+      log_exception(std::system_error(std::error_code(result, std::system_category()), "Failed to initialize Winsock"));
+      return;
+   }
+#endif
+
+   sockaddr_un addr;
+   std::memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   if (server_socket_path_.size() >= sizeof(addr.sun_path)) {
+      set_status_(status_cli_error);
+      log_exception(fs::filesystem_error("Socket path is too long", server_socket_path_, std::make_error_code(std::errc::filename_too_long)));
+      return;
+   }
+   std::memcpy(addr.sun_path, server_socket_path_.c_str(), server_socket_path_.size());
+
+#ifndef _WIN32
+   // A socket left behind by a previous server would prevent binding, but
+   // anything other than a socket is left alone.
+   std::error_code ec;
+   if (fs::is_socket(server_socket_path_, ec)) {
+      fs::remove(server_socket_path_, ec);
+   }
+#endif
+
+   socket_type listener = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (listener == invalid_socket) {
+      set_status_(status_exception);
+      log_exception(std::system_error(last_socket_error(), "Failed to create socket"));
+      return;
+   }
+
+   if (bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 16) != 0) {
+      set_status_(status_exception);
+      log_exception(fs::filesystem_error("Failed to listen on socket", server_socket_path_, last_socket_error()));
+      close_socket(listener);
+      return;
+   }
+
+   be_info() << "Listening for requests"
+      & attr("Socket") << server_socket_path_
+      | default_log();
+
+   active_listener = listener;
+   install_stop_handlers();
+
+   // Connections are handled one at a time, and each request gets the whole
+   // (already running) job pool to itself.  The server stops when it
+   // receives a --quit request, SIGINT, or SIGTERM.
+   bool quit = false;
+   while (!quit && !stop_requested) {
+      socket_type client = accept(listener, nullptr, nullptr);
+      if (client == invalid_socket) {
+         if (stop_requested) {
+            break;
+         }
+#ifndef _WIN32
+         if (errno == EINTR) {
+            continue;
+         }
+#endif
+         set_status_(status_exception);
+         log_exception(std::system_error(last_socket_error(), "Failed to accept connection"));
+         break;
+      }
+
+      S pending;
+      char buf[4096];
+      bool connected = true;
+      while (connected) {
+         auto received = recv(client, buf, int(sizeof(buf)), 0);
+         if (received <= 0) {
+            break;
+         }
+         pending.append(buf, std::size_t(received));
+
+         std::size_t line_end;
+         while (connected && (line_end = pending.find('\n')) != S::npos) {
+            S line = pending.substr(0, line_end);
+            pending.erase(0, line_end + 1);
+
+            std::vector<S> args = tools::split_command_line(line);
+            if (args.empty()) {
+               continue;
+            }
+
+            if (args.size() == 1 && args.front() == "--quit") {
+               send_all(client, "0\t0\n");
+               connected = false;
+               quit = true;
+               break;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            auto verbosity_mask = default_log().verbosity_mask();
+            std::unique_ptr<AtexApp> app = make_job_app_(args);
+            default_log().verbosity_mask(verbosity_mask);
+            int status = (*app)();
+            app.reset();
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+            be_verbose() << "Request finished"
+               & attr("Exit Code") << status
+               & attr("Microseconds") << us
+               | default_log();
+
+            connected = send_all(client, std::to_string(status) + '\t' + std::to_string(us) + '\n');
+         }
+      }
+
+      close_socket(client);
+   }
+
+   remove_stop_handlers();
+   listener = active_listener.exchange(invalid_socket);
+   if (listener != invalid_socket) {
+      close_socket(listener);
+   }
+
+   std::error_code remove_ec;
+   fs::remove(server_socket_path_, remove_ec);
+
+   be_info() << "Server stopped"
+      & attr("Socket") << server_socket_path_
+      | default_log();
+
+#ifdef _WIN32
+   WSACleanup();
+#endif
+}
+
+} // be::atex
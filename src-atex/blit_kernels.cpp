@@ -0,0 +1,487 @@
+#include "blit_kernels.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BE_ATEX_BLIT_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BE_ATEX_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BE_ATEX_TARGET(isa)
+#endif
+
+namespace be::atex {
+namespace {
+
+using namespace gfx::tex;
+
+///////////////////////////////////////////////////////////////////////////////
+const UC* bytes(const void* ptr) {
+   return static_cast<const UC*>(ptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+UC* bytes(void* ptr) {
+   return static_cast<UC*>(ptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+struct CpuFeatures {
+   bool sse41 = false;
+   bool avx2 = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+CpuFeatures detect_cpu_features() {
+   CpuFeatures features;
+#if defined(BE_ATEX_BLIT_KERNELS_X86) && defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 0);
+   int max_leaf = info[0];
+   __cpuid(info, 1);
+   bool ssse3 = (info[2] & (1 << 9)) != 0;
+   features.sse41 = ssse3 && (info[2] & (1 << 19)) != 0;
+   bool os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+   if (max_leaf >= 7 && os_avx) {
+      __cpuidex(info, 7, 0);
+      features.avx2 = (info[1] & (1 << 5)) != 0;
+   }
+#elif defined(BE_ATEX_BLIT_KERNELS_X86)
+   __builtin_cpu_init();
+   features.sse41 = __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1");
+   features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+   features.avx2 = features.avx2 && features.sse41;
+   return features;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const CpuFeatures& cpu_features() {
+   static const CpuFeatures features = detect_cpu_features();
+   return features;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Entries [0, 256) map sRGB-encoded bytes to linear values; entries
+// [256, 512) map linear unorm bytes (ie. alpha) to floats.
+const F32* srgb8_to_linear_lut() {
+   static const std::array<F32, 512> lut = []() {
+      std::array<F32, 512> table;
+      for (std::size_t i = 0; i < 256; ++i) {
+         F64 c = F64(i) / 255.0;
+         table[i] = F32(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+         table[256 + i] = F32(i) / 255.f;
+      }
+      return table;
+   }();
+   return lut.data();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U8 premultiply_channel(U32 c, U32 a) {
+   // round(c * a / 255) without a division
+   U32 t = c * a + 128;
+   return U8((t + (t >> 8)) >> 8);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U8 unpremultiply_channel(U32 c, U32 a) {
+   if (a == 0) {
+      return 0;
+   }
+   return U8(std::min((c * 255 + (a >> 1)) / a, 255u));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void copy_rgba8(const UC* src, UC* dest, std::size_t texels) {
+   std::memcpy(dest, src, texels * 4);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void swap_rb_rgba8_scalar(const UC* src, UC* dest, std::size_t texels) {
+   for (std::size_t i = 0; i < texels; ++i, src += 4, dest += 4) {
+      UC r = src[0];
+      UC b = src[2];
+      dest[0] = b;
+      dest[1] = src[1];
+      dest[2] = r;
+      dest[3] = src[3];
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void premultiply_rgba8_scalar(const UC* src, UC* dest, std::size_t texels) {
+   for (std::size_t i = 0; i < texels; ++i, src += 4, dest += 4) {
+      U32 a = src[3];
+      dest[0] = premultiply_channel(src[0], a);
+      dest[1] = premultiply_channel(src[1], a);
+      dest[2] = premultiply_channel(src[2], a);
+      dest[3] = UC(a);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void unpremultiply_rgba8_scalar(const UC* src, UC* dest, std::size_t texels) {
+   for (std::size_t i = 0; i < texels; ++i, src += 4, dest += 4) {
+      U32 a = src[3];
+      dest[0] = unpremultiply_channel(src[0], a);
+      dest[1] = unpremultiply_channel(src[1], a);
+      dest[2] = unpremultiply_channel(src[2], a);
+      dest[3] = UC(a);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <bool SwapRB>
+void srgb8_to_linear_f32_scalar(const UC* src, UC* dest, std::size_t texels) {
+   const F32* lut = srgb8_to_linear_lut();
+   F32* out = reinterpret_cast<F32*>(dest);
+   for (std::size_t i = 0; i < texels; ++i, src += 4, out += 4) {
+      out[0] = lut[src[SwapRB ? 2 : 0]];
+      out[1] = lut[src[1]];
+      out[2] = lut[src[SwapRB ? 0 : 2]];
+      out[3] = lut[256 + src[3]];
+   }
+}
+
+#ifdef BE_ATEX_BLIT_KERNELS_X86
+
+///////////////////////////////////////////////////////////////////////////////
+// c contains 16-bit channels; see premultiply_channel()
+BE_ATEX_TARGET("ssse3,sse4.1")
+inline __m128i premultiply_lanes_sse41(__m128i c, __m128i alpha_shuffle, __m128i bias) {
+   __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, _mm_shuffle_epi8(c, alpha_shuffle)), bias);
+   return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_ATEX_TARGET("avx2")
+inline __m256i premultiply_lanes_avx2(__m256i c, __m256i alpha_shuffle, __m256i bias) {
+   __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(c, _mm256_shuffle_epi8(c, alpha_shuffle)), bias);
+   return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// (c * 255 + a / 2) / a is computed in single precision; the numerator is
+// always exactly representable and the quotient is never close enough to the
+// next integer to round up to it, so truncation matches integer division.
+// Lanes where a == 0 produce garbage which is masked off by nonzero.
+template <int Shift>
+BE_ATEX_TARGET("ssse3,sse4.1")
+inline __m128i unpremultiply_lanes_sse41(__m128i v, __m128 fa, __m128 half, __m128i nonzero) {
+   __m128i c = _mm_and_si128(_mm_srli_epi32(v, Shift), _mm_set1_epi32(0xFF));
+   __m128 n = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(255.f)), half);
+   __m128i q = _mm_min_epi32(_mm_cvttps_epi32(_mm_div_ps(n, fa)), _mm_set1_epi32(255));
+   return _mm_slli_epi32(_mm_and_si128(q, nonzero), Shift);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <int Shift>
+BE_ATEX_TARGET("avx2")
+inline __m256i unpremultiply_lanes_avx2(__m256i v, __m256 fa, __m256 half, __m256i nonzero) {
+   __m256i c = _mm256_and_si256(_mm256_srli_epi32(v, Shift), _mm256_set1_epi32(0xFF));
+   __m256 n = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(c), _mm256_set1_ps(255.f)), half);
+   __m256i q = _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_div_ps(n, fa)), _mm256_set1_epi32(255));
+   return _mm256_slli_epi32(_mm256_and_si256(q, nonzero), Shift);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_ATEX_TARGET("ssse3,sse4.1")
+void swap_rb_rgba8_sse41(const UC* src, UC* dest, std::size_t texels) {
+   const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+   std::size_t i = 0;
+   for (; i + 4 <= texels; i += 4) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), _mm_shuffle_epi8(v, shuffle));
+   }
+   swap_rb_rgba8_scalar(src + i * 4, dest + i * 4, texels - i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_ATEX_TARGET("avx2")
+void swap_rb_rgba8_avx2(const UC* src, UC* dest, std::size_t texels) {
+   const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+   std::size_t i = 0;
+   for (; i + 8 <= texels; i += 8) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 4), _mm256_shuffle_epi8(v, shuffle));
+   }
+   swap_rb_rgba8_sse41(src + i * 4, dest + i * 4, texels - i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_ATEX_TARGET("ssse3,sse4.1")
+void premultiply_rgba8_sse41(const UC* src, UC* dest, std::size_t texels) {
+   const __m128i alpha_shuffle = _mm_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+   const __m128i alpha_mask = _mm_set1_epi32(I32(0xFF000000));
+   const __m128i bias = _mm_set1_epi16(128);
+   const __m128i zero = _mm_setzero_si128();
+
+   std::size_t i = 0;
+   for (; i + 4 <= texels; i += 4) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+      __m128i lo = premultiply_lanes_sse41(_mm_unpacklo_epi8(v, zero), alpha_shuffle, bias);
+      __m128i hi = premultiply_lanes_sse41(_mm_unpackhi_epi8(v, zero), alpha_shuffle, bias);
+      __m128i result = _mm_blendv_epi8(_mm_packus_epi16(lo, hi), v, alpha_mask);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), result);
+   }
+   premultiply_rgba8_scalar(src + i * 4, dest + i * 4, texels - i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_ATEX_TARGET("avx2")
+void premultiply_rgba8_avx2(const UC* src, UC* dest, std::size_t texels) {
+   const __m256i alpha_shuffle = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15,
+                                                  6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+   const __m256i alpha_mask = _mm256_set1_epi32(I32(0xFF000000));
+   const __m256i bias = _mm256_set1_epi16(128);
+   const __m256i zero = _mm256_setzero_si256();
+
+   std::size_t i = 0;
+   for (; i + 8 <= texels; i += 8) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+      __m256i lo = premultiply_lanes_avx2(_mm256_unpacklo_epi8(v, zero), alpha_shuffle, bias);
+      __m256i hi = premultiply_lanes_avx2(_mm256_unpackhi_epi8(v, zero), alpha_shuffle, bias);
+      __m256i result = _mm256_blendv_epi8(_mm256_packus_epi16(lo, hi), v, alpha_mask);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 4), result);
+   }
+   premultiply_rgba8_sse41(src + i * 4, dest + i * 4, texels - i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_ATEX_TARGET("ssse3,sse4.1")
+void unpremultiply_rgba8_sse41(const UC* src, UC* dest, std::size_t texels) {
+   const __m128i alpha_mask = _mm_set1_epi32(I32(0xFF000000));
+
+   std::size_t i = 0;
+   for (; i + 4 <= texels; i += 4) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+      __m128i a = _mm_srli_epi32(v, 24);
+      __m128i nonzero = _mm_cmpgt_epi32(a, _mm_setzero_si128());
+      __m128 fa = _mm_cvtepi32_ps(a);
+      __m128 half = _mm_cvtepi32_ps(_mm_srli_epi32(a, 1));
+
+      __m128i r = unpremultiply_lanes_sse41<0>(v, fa, half, nonzero);
+      __m128i g = unpremultiply_lanes_sse41<8>(v, fa, half, nonzero);
+      __m128i b = unpremultiply_lanes_sse41<16>(v, fa, half, nonzero);
+      __m128i result = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_and_si128(v, alpha_mask)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), result);
+   }
+   unpremultiply_rgba8_scalar(src + i * 4, dest + i * 4, texels - i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_ATEX_TARGET("avx2")
+void unpremultiply_rgba8_avx2(const UC* src, UC* dest, std::size_t texels) {
+   const __m256i alpha_mask = _mm256_set1_epi32(I32(0xFF000000));
+
+   std::size_t i = 0;
+   for (; i + 8 <= texels; i += 8) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+      __m256i a = _mm256_srli_epi32(v, 24);
+      __m256i nonzero = _mm256_cmpgt_epi32(a, _mm256_setzero_si256());
+      __m256 fa = _mm256_cvtepi32_ps(a);
+      __m256 half = _mm256_cvtepi32_ps(_mm256_srli_epi32(a, 1));
+
+      __m256i r = unpremultiply_lanes_avx2<0>(v, fa, half, nonzero);
+      __m256i g = unpremultiply_lanes_avx2<8>(v, fa, half, nonzero);
+      __m256i b = unpremultiply_lanes_avx2<16>(v, fa, half, nonzero);
+      __m256i result = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, _mm256_and_si256(v, alpha_mask)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 4), result);
+   }
+   unpremultiply_rgba8_sse41(src + i * 4, dest + i * 4, texels - i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// No gather before AVX2, so the lookups are scalar; the channel swap, widening
+// and alpha offset are done on one texel per register.
+template <bool SwapRB>
+BE_ATEX_TARGET("ssse3,sse4.1")
+void srgb8_to_linear_f32_sse41(const UC* src, UC* dest, std::size_t texels) {
+   const F32* lut = srgb8_to_linear_lut();
+   const __m128i shuffle = SwapRB ? _mm_setr_epi8(2, 1, 0, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+                                  : _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+   const __m128i alpha_offset = _mm_setr_epi32(0, 0, 0, 256);
+   F32* out = reinterpret_cast<F32*>(dest);
+
+   alignas(16) I32 index[4];
+   for (std::size_t i = 0; i < texels; ++i) {
+      I32 texel;
+      std::memcpy(&texel, src + i * 4, sizeof(texel));
+      __m128i v = _mm_shuffle_epi8(_mm_cvtsi32_si128(texel), shuffle);
+      _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_add_epi32(_mm_cvtepu8_epi32(v), alpha_offset));
+      _mm_storeu_ps(out + i * 4, _mm_setr_ps(lut[index[0]], lut[index[1]], lut[index[2]], lut[index[3]]));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <bool SwapRB>
+BE_ATEX_TARGET("avx2")
+void srgb8_to_linear_f32_avx2(const UC* src, UC* dest, std::size_t texels) {
+   const F32* lut = srgb8_to_linear_lut();
+   const __m128i shuffle = SwapRB ? _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15)
+                                  : _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+   const __m256i alpha_offset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+   F32* out = reinterpret_cast<F32*>(dest);
+
+   std::size_t i = 0;
+   for (; i + 2 <= texels; i += 2) {
+      __m128i v = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4)), shuffle);
+      __m256i index = _mm256_add_epi32(_mm256_cvtepu8_epi32(v), alpha_offset);
+      _mm256_storeu_ps(out + i * 4, _mm256_i32gather_ps(lut, index, 4));
+   }
+   srgb8_to_linear_f32_scalar<SwapRB>(src + i * 4, dest + i * 16, texels - i);
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+enum class Rgba8Order {
+   other,
+   rgba,
+   bgra
+};
+
+///////////////////////////////////////////////////////////////////////////////
+bool has_field_types(const ImageFormat& format, FieldType type) {
+   for (glm::length_t c = 0; c < 4; ++c) {
+      if (format.field_type(c) != type) {
+         return false;
+      }
+   }
+   return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Rgba8Order rgba8_order(const ImageFormat& format) {
+   if (format.packing() != BlockPacking::s_8_8_8_8 ||
+       format.block_dim() != ImageFormat::block_dim_type(1) ||
+       format.block_size() != 4 ||
+       format.components() != 4 ||
+       !has_field_types(format, FieldType::unorm)) {
+      return Rgba8Order::other;
+   }
+
+   ImageFormat::swizzles_type rgba = swizzles_rgba();
+   ImageFormat::swizzles_type bgra = rgba;
+   std::swap(bgra.r, bgra.b);
+
+   if (format.swizzles() == rgba) {
+      return Rgba8Order::rgba;
+   } else if (format.swizzles() == bgra) {
+      return Rgba8Order::bgra;
+   }
+   return Rgba8Order::other;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool is_rgba32f(const ImageFormat& format) {
+   return format.packing() == BlockPacking::s_32_32_32_32 &&
+      format.block_dim() == ImageFormat::block_dim_type(1) &&
+      format.block_size() == 16 &&
+      format.components() == 4 &&
+      has_field_types(format, FieldType::sfloat) &&
+      format.swizzles() == swizzles_rgba();
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+blit_kernel find_blit_kernel(const ImageFormat& src, const ImageFormat& dest) {
+   const CpuFeatures& cpu = cpu_features();
+
+   Rgba8Order src_order = rgba8_order(src);
+   if (src_order == Rgba8Order::other) {
+      return nullptr;
+   }
+
+   Rgba8Order dest_order = rgba8_order(dest);
+   if (dest_order != Rgba8Order::other) {
+      if (src.colorspace() != dest.colorspace()) {
+         return nullptr;
+      }
+
+      if (src.premultiplied() == dest.premultiplied()) {
+         if (src_order == dest_order) {
+            return copy_rgba8;
+         }
+#ifdef BE_ATEX_BLIT_KERNELS_X86
+         if (cpu.avx2) return swap_rb_rgba8_avx2;
+         if (cpu.sse41) return swap_rb_rgba8_sse41;
+#endif
+         return swap_rb_rgba8_scalar;
+      }
+
+      // premultiplication of sRGB data isn't a simple per-byte operation
+      if (src_order != dest_order || src.colorspace() == Colorspace::srgb) {
+         return nullptr;
+      }
+
+      if (dest.premultiplied()) {
+#ifdef BE_ATEX_BLIT_KERNELS_X86
+         if (cpu.avx2) return premultiply_rgba8_avx2;
+         if (cpu.sse41) return premultiply_rgba8_sse41;
+#endif
+         return premultiply_rgba8_scalar;
+      } else {
+#ifdef BE_ATEX_BLIT_KERNELS_X86
+         if (cpu.avx2) return unpremultiply_rgba8_avx2;
+         if (cpu.sse41) return unpremultiply_rgba8_sse41;
+#endif
+         return unpremultiply_rgba8_scalar;
+      }
+   }
+
+   if (is_rgba32f(dest) &&
+       src.colorspace() == Colorspace::srgb && dest.colorspace() == Colorspace::linear_srgb &&
+       !src.premultiplied() && !dest.premultiplied()) {
+      bool swap_rb = src_order == Rgba8Order::bgra;
+#ifdef BE_ATEX_BLIT_KERNELS_X86
+      if (cpu.avx2) return swap_rb ? srgb8_to_linear_f32_avx2<true> : srgb8_to_linear_f32_avx2<false>;
+      if (cpu.sse41) return swap_rb ? srgb8_to_linear_f32_sse41<true> : srgb8_to_linear_f32_sse41<false>;
+#endif
+      return swap_rb ? srgb8_to_linear_f32_scalar<true> : srgb8_to_linear_f32_scalar<false>;
+   }
+
+   return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool blit_pixels_fast(const ConstImageView& src, const ImageView& dest, const ImageRegion& region) {
+   if (src.block_span() != src.format().block_size() ||
+       dest.block_span() != dest.format().block_size()) {
+      return false;
+   }
+
+   blit_kernel kernel = find_blit_kernel(src.format(), dest.format());
+   if (!kernel) {
+      return false;
+   }
+
+   auto extents = region.extents();
+   const UC* src_data = bytes(src.data());
+   UC* dest_data = bytes(dest.data());
+   std::size_t src_texel_size = src.format().block_size();
+   std::size_t dest_texel_size = dest.format().block_size();
+
+   for (I32 z = extents.offset.z; z < extents.offset.z + extents.dim.z; ++z) {
+      for (I32 y = extents.offset.y; y < extents.offset.y + extents.dim.y; ++y) {
+         const UC* src_line = src_data + z * src.plane_span() + y * src.line_span() + extents.offset.x * src_texel_size;
+         UC* dest_line = dest_data + z * dest.plane_span() + y * dest.line_span() + extents.offset.x * dest_texel_size;
+         kernel(src_line, dest_line, std::size_t(extents.dim.x));
+      }
+   }
+
+   return true;
+}
+
+} // be::atex
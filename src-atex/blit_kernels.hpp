@@ -0,0 +1,25 @@
+#pragma once
+#ifndef BE_ATEX_BLIT_KERNELS_HPP_
+#define BE_ATEX_BLIT_KERNELS_HPP_
+
+#include <be/gfx/tex/texture.hpp>
+#include <be/gfx/tex/blit_pixels.hpp>
+
+namespace be::atex {
+
+// Converts a run of texels from one specific format to another.
+using blit_kernel = void(*)(const UC* src, UC* dest, std::size_t texels);
+
+// Returns a kernel specialized for converting between the given formats using
+// the best instruction set supported by the CPU, or nullptr if the pair must
+// be converted with the generic blit_pixels().
+blit_kernel find_blit_kernel(const gfx::tex::ImageFormat& src, const gfx::tex::ImageFormat& dest);
+
+// Copies the region from src to the same region in dest if a specialized
+// kernel exists for the format pair.  Returns false (without modifying dest)
+// otherwise.
+bool blit_pixels_fast(const gfx::tex::ConstImageView& src, const gfx::tex::ImageView& dest, const gfx::tex::ImageRegion& region);
+
+} // be::atex
+
+#endif
@@ -0,0 +1,163 @@
+#include "block_codec.hpp"
+
+namespace be::atex {
+namespace {
+
+using namespace gfx::tex;
+
+///////////////////////////////////////////////////////////////////////////////
+void expand_565(U16 c, U8 (&rgba)[4]) {
+   U32 r = (c >> 11) & 0x1F;
+   U32 g = (c >> 5) & 0x3F;
+   U32 b = c & 0x1F;
+   rgba[0] = U8((r << 3) | (r >> 2));
+   rgba[1] = U8((g << 2) | (g >> 4));
+   rgba[2] = U8((b << 3) | (b >> 2));
+   rgba[3] = 255;
+}
+
+} // be::atex::()
+
+const U8 bptc_weights2[4] = { 0, 21, 43, 64 };
+const U8 bptc_weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+const U8 bptc_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+///////////////////////////////////////////////////////////////////////////////
+BlockCodec block_codec(const ImageFormat& format) {
+   if (format.block_dim() != ImageFormat::block_dim_type(4, 4, 1)) {
+      return BlockCodec::none;
+   }
+
+   FieldType type = format.field_type(0);
+   switch (format.packing()) {
+      case BlockPacking::c_s3tc1:
+         return type == FieldType::unorm ? BlockCodec::bc1 : BlockCodec::none;
+      case BlockPacking::c_s3tc2:
+         return type == FieldType::unorm ? BlockCodec::bc2 : BlockCodec::none;
+      case BlockPacking::c_s3tc3:
+         return type == FieldType::unorm ? BlockCodec::bc3 : BlockCodec::none;
+      case BlockPacking::c_rgtc1:
+         return type == FieldType::unorm ? BlockCodec::bc4 : BlockCodec::none;
+      case BlockPacking::c_rgtc2:
+         return type == FieldType::unorm ? BlockCodec::bc5 : BlockCodec::none;
+      case BlockPacking::c_bptc:
+         switch (type) {
+            case FieldType::unorm:  return BlockCodec::bc7;
+            case FieldType::ufloat: return BlockCodec::bc6h_unsigned;
+            case FieldType::sfloat: return BlockCodec::bc6h_signed;
+            default:                return BlockCodec::none;
+         }
+      default:
+         return BlockCodec::none;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool is_block_codec_packing(BlockPacking packing) {
+   switch (packing) {
+      case BlockPacking::c_s3tc1:
+      case BlockPacking::c_s3tc2:
+      case BlockPacking::c_s3tc3:
+      case BlockPacking::c_rgtc1:
+      case BlockPacking::c_rgtc2:
+      case BlockPacking::c_bptc:
+         return true;
+      default:
+         return false;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::size_t block_codec_size(BlockCodec codec) {
+   switch (codec) {
+      case BlockCodec::none:
+         return 0;
+      case BlockCodec::bc1:
+      case BlockCodec::bc4:
+         return 8;
+      default:
+         return 16;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ImageFormat block_codec_texel_format(const ImageFormat& format) {
+   BlockCodec codec = block_codec(format);
+   bool hdr = codec == BlockCodec::bc6h_unsigned || codec == BlockCodec::bc6h_signed;
+
+   ImageFormat result = format;
+   result.packing(hdr ? BlockPacking::s_32_32_32_32 : BlockPacking::s_8_8_8_8);
+   result.block_dim(ImageFormat::block_dim_type(1));
+   result.block_size(hdr ? 16 : 4);
+   result.field_types(ImageFormat::field_types_type(hdr ? FieldType::sfloat : FieldType::unorm));
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void s3tc_palette(U16 c0, U16 c1, bool four_color, U8 (&palette)[4][4]) {
+   expand_565(c0, palette[0]);
+   expand_565(c1, palette[1]);
+
+   if (four_color || c0 > c1) {
+      for (std::size_t c = 0; c < 3; ++c) {
+         palette[2][c] = U8((2u * palette[0][c] + palette[1][c] + 1u) / 3u);
+         palette[3][c] = U8((palette[0][c] + 2u * palette[1][c] + 1u) / 3u);
+      }
+      palette[2][3] = 255;
+      palette[3][3] = 255;
+   } else {
+      for (std::size_t c = 0; c < 3; ++c) {
+         palette[2][c] = U8((palette[0][c] + palette[1][c] + 1u) / 2u);
+         palette[3][c] = 0;
+      }
+      palette[2][3] = 255;
+      palette[3][3] = 0;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void rgtc_palette(U8 e0, U8 e1, U8 (&palette)[8]) {
+   palette[0] = e0;
+   palette[1] = e1;
+   if (e0 > e1) {
+      for (U32 k = 2; k < 8; ++k) {
+         palette[k] = U8(((8 - k) * e0 + (k - 1) * e1 + 3) / 7);
+      }
+   } else {
+      for (U32 k = 2; k < 6; ++k) {
+         palette[k] = U8(((6 - k) * e0 + (k - 1) * e1 + 2) / 5);
+      }
+      palette[6] = 0;
+      palette[7] = 255;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+I32 bc6h_unquantize(I32 value, std::size_t bits, bool is_signed) {
+   if (!is_signed) {
+      if (bits >= 15 || value == 0) {
+         return value;
+      } else if (value == (1 << bits) - 1) {
+         return 0xFFFF;
+      }
+      return ((value << 15) + 0x4000) >> (bits - 1);
+   }
+
+   if (bits >= 16) {
+      return value;
+   }
+
+   bool negative = value < 0;
+   I32 magnitude = negative ? -value : value;
+   I32 result;
+   if (magnitude == 0) {
+      result = 0;
+   } else if (magnitude >= (1 << (bits - 1)) - 1) {
+      result = 0x7FFF;
+   } else {
+      result = ((magnitude << 15) + 0x4000) >> (bits - 1);
+   }
+   return negative ? -result : result;
+}
+
+} // be::atex
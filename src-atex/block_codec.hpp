@@ -0,0 +1,114 @@
+#pragma once
+#ifndef BE_ATEX_BLOCK_CODEC_HPP_
+#define BE_ATEX_BLOCK_CODEC_HPP_
+
+#include <be/gfx/tex/texture.hpp>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+// The 4x4 block-compressed formats which atex can encode and/or decode
+// itself, rather than relying on the input already being in the same format.
+enum class BlockCodec : U8 {
+   none = 0,
+   bc1,           // S3TC DXT1; optional 1-bit alpha
+   bc2,           // S3TC DXT3; explicit 4-bit alpha
+   bc3,           // S3TC DXT5; interpolated alpha
+   bc4,           // RGTC1
+   bc5,           // RGTC2
+   bc6h_unsigned, // BPTC float
+   bc6h_signed,   // BPTC float
+   bc7            // BPTC unorm
+};
+
+BlockCodec block_codec(const gfx::tex::ImageFormat& format);
+bool is_block_codec_packing(gfx::tex::BlockPacking packing);
+std::size_t block_codec_size(BlockCodec codec);
+
+// The uncompressed format that blocks are converted from (when encoding) or
+// to (when decoding).  Fields are stored in the same order as in the
+// compressed format, so swizzles, colorspace, and premultiplication are
+// unchanged: RGBA8 unorm for most codecs, RGBA32F for BC6H.
+gfx::tex::ImageFormat block_codec_texel_format(const gfx::tex::ImageFormat& format);
+
+///////////////////////////////////////////////////////////////////////////////
+// BPTC interpolation weights, out of 64
+extern const U8 bptc_weights2[4];
+extern const U8 bptc_weights3[8];
+extern const U8 bptc_weights4[16];
+
+///////////////////////////////////////////////////////////////////////////////
+// Expands an S3TC color block's endpoints to the RGB palette it selects
+// from.  If four_color is false, the 3-color + transparent black palette is
+// used when c0 <= c1 (BC1 only; BC2 and BC3 always use four colors).
+// Alpha is 255 except for the transparent entry.
+void s3tc_palette(U16 c0, U16 c1, bool four_color, U8 (&palette)[4][4]);
+
+// Expands an RGTC/BC3 alpha block's endpoints to the palette it selects from.
+void rgtc_palette(U8 e0, U8 e1, U8 (&palette)[8]);
+
+///////////////////////////////////////////////////////////////////////////////
+// BC6H endpoint unquantization and final scaling, as described in the D3D11
+// functional spec.  bc6h_finish() returns the magnitude of the resulting
+// half-float bit pattern, negated if the sign bit should be set.
+I32 bc6h_unquantize(I32 value, std::size_t bits, bool is_signed);
+
+inline I32 bc6h_finish(I32 value, bool is_signed) {
+   if (!is_signed) {
+      return (value * 31) >> 6;
+   }
+   return value < 0 ? -(((-value) * 31) >> 5) : (value * 31) >> 5;
+}
+
+inline U16 bc6h_half_bits(I32 value) {
+   return value < 0 ? U16(0x8000 | -value) : U16(value);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Writes fields LSB-first into a 128-bit block, as used by BPTC.
+class BlockBitWriter final {
+public:
+   void write(U32 value, std::size_t bits) {
+      for (std::size_t i = 0; i < bits; ++i, ++pos_) {
+         if (value & (1u << i)) {
+            data_[pos_ >> 3] |= UC(1u << (pos_ & 7));
+         }
+      }
+   }
+
+   const UC* data() const {
+      return data_;
+   }
+
+private:
+   UC data_[16] = { };
+   std::size_t pos_ = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Reads fields LSB-first from a 128-bit block, as used by BPTC.
+class BlockBitReader final {
+public:
+   explicit BlockBitReader(const UC* data) {
+      for (std::size_t i = 0; i < 8; ++i) {
+         lo_ |= U64(data[i]) << (8 * i);
+         hi_ |= U64(data[i + 8]) << (8 * i);
+      }
+   }
+
+   // Consumes the next bits; bits must be less than 32.
+   U32 read(std::size_t bits) {
+      U32 value = U32(lo_ & ((U64(1) << bits) - 1));
+      lo_ = (lo_ >> bits) | ((hi_ << 1) << (63 - bits));
+      hi_ >>= bits;
+      return value;
+   }
+
+private:
+   U64 lo_ = 0;
+   U64 hi_ = 0;
+};
+
+} // be::atex
+
+#endif
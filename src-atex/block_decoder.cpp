@@ -0,0 +1,782 @@
+#include "block_decoder.hpp"
+#include "block_codec.hpp"
+#include <be/core/glm.hpp>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP) && _M_IX86_FP >= 2
+#define BE_ATEX_BLOCK_DECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace be::atex {
+namespace {
+
+using namespace gfx::tex;
+
+///////////////////////////////////////////////////////////////////////////////
+// BPTC partition tables, shared by BC6H (first 32 entries of the 2-subset
+// table) and BC7.  Bit i of a 2-subset mask is the subset of texel i.
+const U16 bptc_partitions2[64] = {
+   0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+   0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+   0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+   0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+   0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+   0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+   0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+   0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+const U8 bptc_partitions3[64][16] = {
+   { 0,0,1,1, 0,0,1,1, 0,2,2,1, 2,2,2,2 }, { 0,0,0,1, 0,0,1,1, 2,2,1,1, 2,2,2,1 },
+   { 0,0,0,0, 2,0,0,1, 2,2,1,1, 2,2,1,1 }, { 0,2,2,2, 0,0,2,2, 0,0,1,1, 0,1,1,1 },
+   { 0,0,0,0, 0,0,0,0, 1,1,2,2, 1,1,2,2 }, { 0,0,1,1, 0,0,1,1, 0,0,2,2, 0,0,2,2 },
+   { 0,0,2,2, 0,0,2,2, 1,1,1,1, 1,1,1,1 }, { 0,0,1,1, 0,0,1,1, 2,2,1,1, 2,2,1,1 },
+   { 0,0,0,0, 0,0,0,0, 1,1,1,1, 2,2,2,2 }, { 0,0,0,0, 1,1,1,1, 1,1,1,1, 2,2,2,2 },
+   { 0,0,0,0, 1,1,1,1, 2,2,2,2, 2,2,2,2 }, { 0,0,1,2, 0,0,1,2, 0,0,1,2, 0,0,1,2 },
+   { 0,1,1,2, 0,1,1,2, 0,1,1,2, 0,1,1,2 }, { 0,1,2,2, 0,1,2,2, 0,1,2,2, 0,1,2,2 },
+   { 0,0,1,1, 0,1,1,2, 1,1,2,2, 1,2,2,2 }, { 0,0,1,1, 2,0,0,1, 2,2,0,0, 2,2,2,0 },
+   { 0,0,0,1, 0,0,1,1, 0,1,1,2, 1,1,2,2 }, { 0,1,1,1, 0,0,1,1, 2,0,0,1, 2,2,0,0 },
+   { 0,0,0,0, 1,1,2,2, 1,1,2,2, 1,1,2,2 }, { 0,0,2,2, 0,0,2,2, 0,0,2,2, 1,1,1,1 },
+   { 0,1,1,1, 0,1,1,1, 0,2,2,2, 0,2,2,2 }, { 0,0,0,1, 0,0,0,1, 2,2,2,1, 2,2,2,1 },
+   { 0,0,0,0, 0,0,1,1, 0,1,2,2, 0,1,2,2 }, { 0,0,0,0, 1,1,0,0, 2,2,1,0, 2,2,1,0 },
+   { 0,1,2,2, 0,1,2,2, 0,0,1,1, 0,0,0,0 }, { 0,0,1,2, 0,0,1,2, 1,1,2,2, 2,2,2,2 },
+   { 0,1,1,0, 1,2,2,1, 1,2,2,1, 0,1,1,0 }, { 0,0,0,0, 0,1,1,0, 1,2,2,1, 1,2,2,1 },
+   { 0,0,2,2, 1,1,0,2, 1,1,0,2, 0,0,2,2 }, { 0,1,1,0, 0,1,1,0, 2,0,0,2, 2,2,2,2 },
+   { 0,0,1,1, 0,1,2,2, 0,1,2,2, 0,0,1,1 }, { 0,0,0,0, 2,0,0,0, 2,2,1,1, 2,2,2,1 },
+   { 0,0,0,0, 0,0,0,2, 1,1,2,2, 1,2,2,2 }, { 0,2,2,2, 0,0,2,2, 0,0,1,2, 0,0,1,1 },
+   { 0,0,1,1, 0,0,1,2, 0,0,2,2, 0,2,2,2 }, { 0,1,2,0, 0,1,2,0, 0,1,2,0, 0,1,2,0 },
+   { 0,0,0,0, 1,1,1,1, 2,2,2,2, 0,0,0,0 }, { 0,1,2,0, 1,2,0,1, 2,0,1,2, 0,1,2,0 },
+   { 0,1,2,0, 2,0,1,2, 1,2,0,1, 0,1,2,0 }, { 0,0,1,1, 2,2,0,0, 1,1,2,2, 0,0,1,1 },
+   { 0,0,1,1, 1,1,2,2, 2,2,0,0, 0,0,1,1 }, { 0,1,0,1, 0,1,0,1, 2,2,2,2, 2,2,2,2 },
+   { 0,0,0,0, 0,0,0,0, 2,1,2,1, 2,1,2,1 }, { 0,0,2,2, 1,1,2,2, 0,0,2,2, 1,1,2,2 },
+   { 0,0,2,2, 0,0,1,1, 0,0,2,2, 0,0,1,1 }, { 0,2,2,0, 1,2,2,1, 0,2,2,0, 1,2,2,1 },
+   { 0,1,0,1, 2,2,2,2, 2,2,2,2, 0,1,0,1 }, { 0,0,0,0, 2,1,2,1, 2,1,2,1, 2,1,2,1 },
+   { 0,1,0,1, 0,1,0,1, 0,1,0,1, 2,2,2,2 }, { 0,2,2,2, 0,1,1,1, 0,2,2,2, 0,1,1,1 },
+   { 0,0,0,2, 1,1,1,2, 0,0,0,2, 1,1,1,2 }, { 0,0,0,0, 2,1,1,2, 2,1,1,2, 2,1,1,2 },
+   { 0,2,2,2, 0,1,1,1, 0,1,1,1, 0,2,2,2 }, { 0,0,0,2, 1,1,1,2, 1,1,1,2, 0,0,0,2 },
+   { 0,1,1,0, 0,1,1,0, 0,1,1,0, 2,2,2,2 }, { 0,0,0,0, 0,0,0,0, 2,1,1,2, 2,1,1,2 },
+   { 0,1,1,0, 0,1,1,0, 2,2,2,2, 2,2,2,2 }, { 0,0,2,2, 0,0,1,1, 0,0,1,1, 0,0,2,2 },
+   { 0,0,2,2, 1,1,2,2, 1,1,2,2, 0,0,2,2 }, { 0,0,0,0, 0,0,0,0, 0,0,0,0, 2,1,1,2 },
+   { 0,0,0,2, 0,0,0,1, 0,0,0,2, 0,0,0,1 }, { 0,2,2,2, 1,2,2,2, 0,2,2,2, 1,2,2,2 },
+   { 0,1,0,1, 2,2,2,2, 2,2,2,2, 2,2,2,2 }, { 0,1,1,1, 2,0,1,1, 2,2,0,1, 2,2,2,0 }
+};
+
+// Index of the texel in subset 1 (and 2) whose index omits its MSB
+const U8 bptc_anchors2[64] = {
+   15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15,
+   15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+   15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,
+    6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15
+};
+
+const U8 bptc_anchors3a[64] = {
+    3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,
+    3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+    8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,
+    3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3
+};
+
+const U8 bptc_anchors3b[64] = {
+   15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8,
+   15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+   15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8,
+   15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8
+};
+
+const U8* bptc_weights(std::size_t bits) {
+   switch (bits) {
+      case 2:  return bptc_weights2;
+      case 3:  return bptc_weights3;
+      default: return bptc_weights4;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U16 read_u16(const UC* in) {
+   return U16(in[0] | (in[1] << 8));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void decode_s3tc_color(const UC* in, bool four_color, U8 (&texels)[16][4]) {
+   U8 palette[4][4];
+   s3tc_palette(read_u16(in), read_u16(in + 2), four_color, palette);
+
+   U32 indices = in[4] | (in[5] << 8) | (in[6] << 16) | (U32(in[7]) << 24);
+   for (std::size_t i = 0; i < 16; ++i, indices >>= 2) {
+      std::memcpy(texels[i], palette[indices & 3], 4);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void decode_bc2_alpha(const UC* in, U8 (&texels)[16][4]) {
+   for (std::size_t i = 0; i < 16; ++i) {
+      U8 alpha = (in[i >> 1] >> ((i & 1) * 4)) & 0xF;
+      texels[i][3] = U8(alpha * 17);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void decode_rgtc_channel(const UC* in, std::size_t channel, U8 (&texels)[16][4]) {
+   U8 palette[8];
+   rgtc_palette(in[0], in[1], palette);
+
+   U64 indices = 0;
+   for (std::size_t i = 0; i < 6; ++i) {
+      indices |= U64(in[2 + i]) << (8 * i);
+   }
+
+   for (std::size_t i = 0; i < 16; ++i, indices >>= 3) {
+      texels[i][channel] = palette[indices & 7];
+   }
+}
+
+#ifdef BE_ATEX_BLOCK_DECODER_SSE2
+///////////////////////////////////////////////////////////////////////////////
+// The _x4 decoders below work on four consecutive blocks at once, one block
+// per 32-bit lane; element i of each __m128i array holds texel i of all four
+// blocks.
+U32 read_u32(const UC* in) {
+   return read_u16(in) | (U32(read_u16(in + 2)) << 16);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+__m128i select_x4(__m128i mask, __m128i a, __m128i b) {
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Expands two 565 colors into 16-bit RGBA lanes (a in lanes 0-3, b in lanes
+// 4-7): each channel is shifted to the top of its lane, masked, and then
+// scaled so that the high half of the product replicates its top bits.
+__m128i expand_565_x2(U16 a, U16 b) {
+   __m128i c = _mm_set_epi16(short(b), short(b), short(b), short(b), short(a), short(a), short(a), short(a));
+   c = _mm_mullo_epi16(c, _mm_set1_epi64x(0x0000080000200001ll));
+   c = _mm_and_si128(c, _mm_set1_epi64x(0x0000F800FC00F800ll));
+   c = _mm_mulhi_epu16(c, _mm_set1_epi64x(0x0000010801040108ll));
+   return _mm_or_si128(c, _mm_set1_epi64x(0x00FF000000000000ll));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Texels are gathered from the palette by comparing each lane's index
+// against every entry.
+void decode_s3tc_color_x4(const UC* in, std::size_t block_span, bool four_color, __m128i (&texels)[16]) {
+   const __m128i one = _mm_set1_epi16(1);
+   const __m128i third = _mm_set1_epi16(0x5556); // x * third >> 16 == x / 3 for x < 768
+   const __m128i sign = _mm_set1_epi16(short(0x8000));
+
+   __m128i palette[4][2];
+   for (std::size_t h = 0; h < 2; ++h) {
+      const UC* a_in = in + 2 * h * block_span;
+      const UC* b_in = a_in + block_span;
+      U16 a0 = read_u16(a_in), a1 = read_u16(a_in + 2);
+      U16 b0 = read_u16(b_in), b1 = read_u16(b_in + 2);
+
+      __m128i p0 = expand_565_x2(a0, b0);
+      __m128i p1 = expand_565_x2(a1, b1);
+      __m128i four = _mm_setzero_si128();
+      if (four_color) {
+         four = _mm_cmpeq_epi16(four, four);
+      } else {
+         __m128i c0 = _mm_set_epi16(short(b0), short(b0), short(b0), short(b0), short(a0), short(a0), short(a0), short(a0));
+         __m128i c1 = _mm_set_epi16(short(b1), short(b1), short(b1), short(b1), short(a1), short(a1), short(a1), short(a1));
+         four = _mm_cmpgt_epi16(_mm_xor_si128(c0, sign), _mm_xor_si128(c1, sign));
+      }
+
+      __m128i p2 = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(p0, p0), _mm_add_epi16(p1, one)), third);
+      __m128i p3 = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(p1, p1), _mm_add_epi16(p0, one)), third);
+      palette[0][h] = p0;
+      palette[1][h] = p1;
+      palette[2][h] = select_x4(four, p2, _mm_avg_epu16(p0, p1));
+      palette[3][h] = _mm_and_si128(four, p3);
+   }
+
+   __m128i entries[4];
+   for (std::size_t k = 0; k < 4; ++k) {
+      entries[k] = _mm_packus_epi16(palette[k][0], palette[k][1]);
+   }
+
+   __m128i indices = _mm_set_epi32(I32(read_u32(in + 3 * block_span + 4)), I32(read_u32(in + 2 * block_span + 4)),
+                                   I32(read_u32(in + block_span + 4)), I32(read_u32(in + 4)));
+   const __m128i mask = _mm_set1_epi32(3);
+   for (std::size_t i = 0; i < 16; ++i, indices = _mm_srli_epi32(indices, 2)) {
+      __m128i index = _mm_and_si128(indices, mask);
+      __m128i texel = _mm_and_si128(_mm_cmpeq_epi32(index, _mm_setzero_si128()), entries[0]);
+      for (I32 k = 1; k < 4; ++k) {
+         texel = _mm_or_si128(texel, _mm_and_si128(_mm_cmpeq_epi32(index, _mm_set1_epi32(k)), entries[k]));
+      }
+      texels[i] = texel;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void decode_bc2_alpha_x4(const UC* in, std::size_t block_span, __m128i (&alpha)[16]) {
+   const __m128i mask = _mm_set1_epi32(0xF);
+   for (std::size_t h = 0; h < 2; ++h) {
+      const UC* word_in = in + h * 4;
+      __m128i nibbles = _mm_set_epi32(I32(read_u32(word_in + 3 * block_span)), I32(read_u32(word_in + 2 * block_span)),
+                                      I32(read_u32(word_in + block_span)), I32(read_u32(word_in)));
+      for (std::size_t i = 0; i < 8; ++i, nibbles = _mm_srli_epi32(nibbles, 4)) {
+         __m128i a = _mm_and_si128(nibbles, mask);
+         alpha[h * 8 + i] = _mm_or_si128(a, _mm_slli_epi32(a, 4));
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Eight entries are too many to select between in registers, so the palettes
+// are built in lanes and stored (entry-major) for a scalar gather by index.
+void decode_rgtc_channel_x4(const UC* in, std::size_t block_span, std::size_t channel, U8 (&texels)[4][16][4]) {
+   const __m128i seventh = _mm_set1_epi16(0x2493); // x * seventh >> 16 == x / 7 for x < 1792
+   const __m128i fifth = _mm_set1_epi16(0x3334);   // x * fifth >> 16 == x / 5 for x < 1280
+   const __m128i round7 = _mm_set1_epi32(3);
+   const __m128i round5 = _mm_set1_epi32(2);
+
+   const UC* in1 = in + block_span;
+   const UC* in2 = in1 + block_span;
+   const UC* in3 = in2 + block_span;
+   __m128i e0 = _mm_set_epi32(in3[0], in2[0], in1[0], in[0]);
+   __m128i e1 = _mm_set_epi32(in3[1], in2[1], in1[1], in[1]);
+   __m128i eight = _mm_cmpgt_epi32(e0, e1);
+
+   // Interpolated entries k = 2..7 step from 7*e0 (or 5*e0) by e1 - e0 each
+   __m128i step = _mm_sub_epi32(e1, e0);
+   __m128i sum7 = _mm_mullo_epi16(e0, _mm_set1_epi32(7));
+   __m128i sum5 = _mm_mullo_epi16(e0, _mm_set1_epi32(5));
+
+   __m128i palette[8];
+   palette[0] = e0;
+   palette[1] = e1;
+   for (std::size_t k = 2; k < 8; ++k) {
+      sum7 = _mm_add_epi32(sum7, step);
+      sum5 = _mm_add_epi32(sum5, step);
+      __m128i lerp7 = _mm_mulhi_epu16(_mm_add_epi32(sum7, round7), seventh);
+      __m128i lerp5;
+      if (k < 6) {
+         lerp5 = _mm_mulhi_epu16(_mm_add_epi32(sum5, round5), fifth);
+      } else if (k == 6) {
+         lerp5 = _mm_setzero_si128();
+      } else {
+         lerp5 = _mm_set1_epi32(255);
+      }
+      palette[k] = select_x4(eight, lerp7, lerp5);
+   }
+
+   alignas(16) U8 entries[8][4];
+   for (std::size_t k = 0; k < 8; k += 4) {
+      __m128i lo = _mm_packs_epi32(palette[k], palette[k + 1]);
+      __m128i hi = _mm_packs_epi32(palette[k + 2], palette[k + 3]);
+      _mm_store_si128(reinterpret_cast<__m128i*>(entries[k]), _mm_packus_epi16(lo, hi));
+   }
+
+   for (std::size_t b = 0; b < 4; ++b, in += block_span) {
+      U64 indices = read_u16(in + 2) | (U64(read_u32(in + 4)) << 16);
+      for (std::size_t i = 0; i < 16; ++i, indices >>= 3) {
+         texels[b][i][channel] = entries[indices & 7][b];
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Decodes four consecutive BC1-BC5 blocks; bit-exact with the scalar path.
+void decode_s3tc_rgtc_x4(const UC* in, std::size_t block_span, BlockCodec codec, U8 (&texels)[4][16][4]) {
+   if (codec == BlockCodec::bc4 || codec == BlockCodec::bc5) {
+      for (auto& block : texels) {
+         for (auto& texel : block) {
+            texel[0] = texel[1] = texel[2] = 0;
+            texel[3] = 255;
+         }
+      }
+      decode_rgtc_channel_x4(in, block_span, 0, texels);
+      if (codec == BlockCodec::bc5) {
+         decode_rgtc_channel_x4(in + 8, block_span, 1, texels);
+      }
+      return;
+   }
+
+   __m128i rgba[16];
+   if (codec == BlockCodec::bc1) {
+      decode_s3tc_color_x4(in, block_span, false, rgba);
+   } else {
+      decode_s3tc_color_x4(in + 8, block_span, true, rgba);
+   }
+
+   if (codec == BlockCodec::bc2) {
+      __m128i alpha[16];
+      decode_bc2_alpha_x4(in, block_span, alpha);
+      const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+      for (std::size_t i = 0; i < 16; ++i) {
+         rgba[i] = _mm_or_si128(_mm_and_si128(rgba[i], rgb_mask), _mm_slli_epi32(alpha[i], 24));
+      }
+   }
+
+   // Transpose so each store writes four consecutive texels of one block
+   for (std::size_t i = 0; i < 16; i += 4) {
+      __m128i t01lo = _mm_unpacklo_epi32(rgba[i], rgba[i + 1]);
+      __m128i t01hi = _mm_unpackhi_epi32(rgba[i], rgba[i + 1]);
+      __m128i t23lo = _mm_unpacklo_epi32(rgba[i + 2], rgba[i + 3]);
+      __m128i t23hi = _mm_unpackhi_epi32(rgba[i + 2], rgba[i + 3]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(texels[0][i]), _mm_unpacklo_epi64(t01lo, t23lo));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(texels[1][i]), _mm_unpackhi_epi64(t01lo, t23lo));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(texels[2][i]), _mm_unpacklo_epi64(t01hi, t23hi));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(texels[3][i]), _mm_unpackhi_epi64(t01hi, t23hi));
+   }
+
+   if (codec == BlockCodec::bc3) {
+      decode_rgtc_channel_x4(in, block_span, 3, texels);
+   }
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+struct Bc7Mode {
+   U8 subsets;
+   U8 partition_bits;
+   U8 rotation_bits;
+   U8 index_selection_bits;
+   U8 color_bits;
+   U8 alpha_bits;
+   U8 endpoint_pbits;
+   U8 shared_pbits;
+   U8 index_bits;
+   U8 index_bits2;
+};
+
+const Bc7Mode bc7_modes[8] = {
+   { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+   { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+   { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+   { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+   { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+   { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+   { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+   { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+void bptc_subsets(std::size_t subsets, std::size_t partition, U8 (&result)[16]) {
+   if (subsets == 3) {
+      std::memcpy(result, bptc_partitions3[partition], sizeof(result));
+   } else if (subsets == 2) {
+      U32 mask = bptc_partitions2[partition];
+      for (std::size_t i = 0; i < 16; ++i, mask >>= 1) {
+         result[i] = U8(mask & 1);
+      }
+   } else {
+      std::memset(result, 0, sizeof(result));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void decode_bc7(const UC* in, U8 (&texels)[16][4]) {
+   BlockBitReader bits(in);
+
+   std::size_t mode = 0;
+   while (mode < 8 && !bits.read(1)) {
+      ++mode;
+   }
+
+   if (mode == 8) {
+      // reserved mode; decodes to transparent black
+      std::memset(texels, 0, sizeof(texels));
+      return;
+   }
+
+   const Bc7Mode& m = bc7_modes[mode];
+   std::size_t partition = bits.read(m.partition_bits);
+   std::size_t rotation = bits.read(m.rotation_bits);
+   std::size_t index_selection = bits.read(m.index_selection_bits);
+
+   U32 endpoints[3][2][4] = { };
+   for (std::size_t c = 0; c < 3; ++c) {
+      for (std::size_t s = 0; s < m.subsets; ++s) {
+         endpoints[s][0][c] = bits.read(m.color_bits);
+         endpoints[s][1][c] = bits.read(m.color_bits);
+      }
+   }
+   for (std::size_t s = 0; s < m.subsets; ++s) {
+      endpoints[s][0][3] = bits.read(m.alpha_bits);
+      endpoints[s][1][3] = bits.read(m.alpha_bits);
+   }
+
+   std::size_t color_bits = m.color_bits;
+   std::size_t alpha_bits = m.alpha_bits;
+   if (m.endpoint_pbits || m.shared_pbits) {
+      for (std::size_t s = 0; s < m.subsets; ++s) {
+         U32 p0 = bits.read(1);
+         U32 p1 = m.shared_pbits ? p0 : bits.read(1);
+         for (std::size_t c = 0; c < 4; ++c) {
+            endpoints[s][0][c] = (endpoints[s][0][c] << 1) | p0;
+            endpoints[s][1][c] = (endpoints[s][1][c] << 1) | p1;
+         }
+      }
+      ++color_bits;
+      if (alpha_bits > 0) {
+         ++alpha_bits;
+      }
+   }
+
+   U16 expanded[3][2][4];
+   for (std::size_t s = 0; s < m.subsets; ++s) {
+      for (std::size_t e = 0; e < 2; ++e) {
+         const U32* ep = endpoints[s][e];
+         for (std::size_t c = 0; c < 3; ++c) {
+            expanded[s][e][c] = U16((ep[c] << (8 - color_bits)) | (ep[c] >> (2 * color_bits - 8)));
+         }
+         if (alpha_bits > 0) {
+            expanded[s][e][3] = U16((ep[3] << (8 - alpha_bits)) | (ep[3] >> (2 * alpha_bits - 8)));
+         } else {
+            expanded[s][e][3] = 255;
+         }
+      }
+   }
+
+   std::size_t anchor1 = m.subsets > 1 ? (m.subsets == 2 ? bptc_anchors2[partition] : bptc_anchors3a[partition]) : 0;
+   std::size_t anchor2 = m.subsets > 2 ? bptc_anchors3b[partition] : 0;
+
+   U8 indices[16];
+   U8 indices2[16] = { };
+   for (std::size_t i = 0; i < 16; ++i) {
+      indices[i] = U8(bits.read(m.index_bits - (i == 0 || i == anchor1 || i == anchor2 ? 1 : 0)));
+   }
+   if (m.index_bits2 > 0) {
+      for (std::size_t i = 0; i < 16; ++i) {
+         indices2[i] = U8(bits.read(m.index_bits2 - (i == 0 ? 1 : 0)));
+      }
+   }
+
+   const U8* color_weights = bptc_weights(m.index_bits);
+   const U8* alpha_weights = color_weights;
+   const U8* color_indices = indices;
+   const U8* alpha_indices = indices;
+   if (m.index_bits2 > 0) {
+      alpha_weights = bptc_weights(m.index_bits2);
+      alpha_indices = indices2;
+      if (index_selection) {
+         std::swap(color_weights, alpha_weights);
+         std::swap(color_indices, alpha_indices);
+      }
+   }
+
+   // Gather each texel's endpoints and weights so that all 64 channels can be
+   // interpolated together.
+   alignas(16) U16 e0[16][4];
+   alignas(16) U16 e1[16][4];
+   alignas(16) U16 weights[16][4];
+   U8 subsets[16];
+   bptc_subsets(m.subsets, partition, subsets);
+   for (std::size_t i = 0; i < 16; ++i) {
+      const U16 (&ep)[2][4] = expanded[subsets[i]];
+      std::memcpy(e0[i], ep[0], sizeof(e0[i]));
+      std::memcpy(e1[i], ep[1], sizeof(e1[i]));
+      U16 cw = color_weights[color_indices[i]];
+      weights[i][0] = cw;
+      weights[i][1] = cw;
+      weights[i][2] = cw;
+      weights[i][3] = alpha_weights[alpha_indices[i]];
+   }
+
+#ifdef BE_ATEX_BLOCK_DECODER_SSE2
+   const __m128i full = _mm_set1_epi16(64);
+   const __m128i round = _mm_set1_epi16(32);
+   for (std::size_t i = 0; i < 16; i += 4) {
+      __m128i result[2];
+      for (std::size_t h = 0; h < 2; ++h) {
+         __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(e0[i + h * 2]));
+         __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(e1[i + h * 2]));
+         __m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(weights[i + h * 2]));
+         __m128i t = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(full, w), a), _mm_mullo_epi16(w, b));
+         result[h] = _mm_srli_epi16(_mm_add_epi16(t, round), 6);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(texels[i]), _mm_packus_epi16(result[0], result[1]));
+   }
+#else
+   for (std::size_t i = 0; i < 16; ++i) {
+      for (std::size_t c = 0; c < 4; ++c) {
+         U32 w = weights[i][c];
+         texels[i][c] = U8(((64 - w) * e0[i][c] + w * e1[i][c] + 32) >> 6);
+      }
+   }
+#endif
+
+   if (rotation > 0) {
+      for (auto& texel : texels) {
+         std::swap(texel[rotation - 1], texel[3]);
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BC6H header fields are scattered through the block; each mode is described
+// by the sequence of bit ranges it stores, in stream order.  Fields are
+// numbered endpoint * 3 + channel, with endpoints w, x, y, z.
+enum Bc6hField : U8 {
+   rw, gw, bw,
+   rx, gx, bx,
+   ry, gy, by,
+   rz, gz, bz
+};
+
+struct Bc6hSegment {
+   U8 field;
+   U8 first_bit; // stored first
+   U8 last_bit;  // may be less than first_bit, for reversed fields
+};
+
+struct Bc6hMode {
+   U8 mode_bits;
+   U8 regions;
+   bool transformed;
+   U8 endpoint_bits;
+   U8 delta_bits[3];
+   std::size_t segment_count;
+   Bc6hSegment segments[24];
+};
+
+const Bc6hMode bc6h_modes[14] = {
+   { 2, 2, true, 10, { 5, 5, 5 }, 19, {
+      { gy,4,4 }, { by,4,4 }, { bz,4,4 }, { rw,0,9 }, { gw,0,9 }, { bw,0,9 }, { rx,0,4 }, { gz,4,4 }, { gy,0,3 }, { gx,0,4 },
+      { bz,0,0 }, { gz,0,3 }, { bx,0,4 }, { bz,1,1 }, { by,0,3 }, { ry,0,4 }, { bz,2,2 }, { rz,0,4 }, { bz,3,3 } } },
+   { 2, 2, true, 7, { 6, 6, 6 }, 23, {
+      { gy,5,5 }, { gz,4,4 }, { gz,5,5 }, { rw,0,6 }, { bz,0,0 }, { bz,1,1 }, { by,4,4 }, { gw,0,6 }, { by,5,5 }, { bz,2,2 },
+      { gy,4,4 }, { bw,0,6 }, { bz,3,3 }, { bz,5,5 }, { bz,4,4 }, { rx,0,5 }, { gy,0,3 }, { gx,0,5 }, { gz,0,3 }, { bx,0,5 },
+      { by,0,3 }, { ry,0,5 }, { rz,0,5 } } },
+   { 5, 2, true, 11, { 5, 4, 4 }, 18, {
+      { rw,0,9 }, { gw,0,9 }, { bw,0,9 }, { rx,0,4 }, { rw,10,10 }, { gy,0,3 }, { gx,0,3 }, { gw,10,10 }, { bz,0,0 }, { gz,0,3 },
+      { bx,0,3 }, { bw,10,10 }, { bz,1,1 }, { by,0,3 }, { ry,0,4 }, { bz,2,2 }, { rz,0,4 }, { bz,3,3 } } },
+   { 5, 2, true, 11, { 4, 5, 4 }, 20, {
+      { rw,0,9 }, { gw,0,9 }, { bw,0,9 }, { rx,0,3 }, { rw,10,10 }, { gz,4,4 }, { gy,0,3 }, { gx,0,4 }, { gw,10,10 }, { gz,0,3 },
+      { bx,0,3 }, { bw,10,10 }, { bz,1,1 }, { by,0,3 }, { ry,0,3 }, { bz,0,0 }, { bz,2,2 }, { rz,0,3 }, { gy,4,4 }, { bz,3,3 } } },
+   { 5, 2, true, 11, { 4, 4, 5 }, 20, {
+      { rw,0,9 }, { gw,0,9 }, { bw,0,9 }, { rx,0,3 }, { rw,10,10 }, { by,4,4 }, { gy,0,3 }, { gx,0,3 }, { gw,10,10 }, { bz,0,0 },
+      { gz,0,3 }, { bx,0,4 }, { bw,10,10 }, { by,0,3 }, { ry,0,3 }, { bz,1,1 }, { bz,2,2 }, { rz,0,3 }, { bz,4,4 }, { bz,3,3 } } },
+   { 5, 2, true, 9, { 5, 5, 5 }, 19, {
+      { rw,0,8 }, { by,4,4 }, { gw,0,8 }, { gy,4,4 }, { bw,0,8 }, { bz,4,4 }, { rx,0,4 }, { gz,4,4 }, { gy,0,3 }, { gx,0,4 },
+      { bz,0,0 }, { gz,0,3 }, { bx,0,4 }, { bz,1,1 }, { by,0,3 }, { ry,0,4 }, { bz,2,2 }, { rz,0,4 }, { bz,3,3 } } },
+   { 5, 2, true, 8, { 6, 5, 5 }, 19, {
+      { rw,0,7 }, { gz,4,4 }, { by,4,4 }, { gw,0,7 }, { bz,2,2 }, { gy,4,4 }, { bw,0,7 }, { bz,3,3 }, { bz,4,4 }, { rx,0,5 },
+      { gy,0,3 }, { gx,0,4 }, { bz,0,0 }, { gz,0,3 }, { bx,0,4 }, { bz,1,1 }, { by,0,3 }, { ry,0,5 }, { rz,0,5 } } },
+   { 5, 2, true, 8, { 5, 6, 5 }, 21, {
+      { rw,0,7 }, { bz,0,0 }, { by,4,4 }, { gw,0,7 }, { gy,5,5 }, { gy,4,4 }, { bw,0,7 }, { gz,5,5 }, { bz,4,4 }, { rx,0,4 },
+      { gz,4,4 }, { gy,0,3 }, { gx,0,5 }, { gz,0,3 }, { bx,0,4 }, { bz,1,1 }, { by,0,3 }, { ry,0,4 }, { bz,2,2 }, { rz,0,4 },
+      { bz,3,3 } } },
+   { 5, 2, true, 8, { 5, 5, 6 }, 21, {
+      { rw,0,7 }, { bz,1,1 }, { by,4,4 }, { gw,0,7 }, { by,5,5 }, { gy,4,4 }, { bw,0,7 }, { bz,5,5 }, { bz,4,4 }, { rx,0,4 },
+      { gz,4,4 }, { gy,0,3 }, { gx,0,4 }, { bz,0,0 }, { gz,0,3 }, { bx,0,5 }, { by,0,3 }, { ry,0,4 }, { bz,2,2 }, { rz,0,4 },
+      { bz,3,3 } } },
+   { 5, 2, false, 6, { 6, 6, 6 }, 23, {
+      { rw,0,5 }, { gz,4,4 }, { bz,0,0 }, { bz,1,1 }, { by,4,4 }, { gw,0,5 }, { gy,5,5 }, { by,5,5 }, { bz,2,2 }, { gy,4,4 },
+      { bw,0,5 }, { gz,5,5 }, { bz,3,3 }, { bz,5,5 }, { bz,4,4 }, { rx,0,5 }, { gy,0,3 }, { gx,0,5 }, { gz,0,3 }, { bx,0,5 },
+      { by,0,3 }, { ry,0,5 }, { rz,0,5 } } },
+   { 5, 1, false, 10, { 10, 10, 10 }, 6, {
+      { rw,0,9 }, { gw,0,9 }, { bw,0,9 }, { rx,0,9 }, { gx,0,9 }, { bx,0,9 } } },
+   { 5, 1, true, 11, { 9, 9, 9 }, 9, {
+      { rw,0,9 }, { gw,0,9 }, { bw,0,9 }, { rx,0,8 }, { rw,10,10 }, { gx,0,8 }, { gw,10,10 }, { bx,0,8 }, { bw,10,10 } } },
+   { 5, 1, true, 12, { 8, 8, 8 }, 9, {
+      { rw,0,9 }, { gw,0,9 }, { bw,0,9 }, { rx,0,7 }, { rw,11,10 }, { gx,0,7 }, { gw,11,10 }, { bx,0,7 }, { bw,11,10 } } },
+   { 5, 1, true, 16, { 4, 4, 4 }, 9, {
+      { rw,0,9 }, { gw,0,9 }, { bw,0,9 }, { rx,0,3 }, { rw,15,10 }, { gx,0,3 }, { gw,15,10 }, { bx,0,3 }, { bw,15,10 } } }
+};
+
+// Maps the 5-bit mode field to an index into bc6h_modes, or -1 if reserved
+const I8 bc6h_mode_index[32] = {
+    0,  1,  2, 10,  0,  1,  3, 11,  0,  1,  4, 12,  0,  1,  5, 13,
+    0,  1,  6, -1,  0,  1,  7, -1,  0,  1,  8, -1,  0,  1,  9, -1
+};
+
+///////////////////////////////////////////////////////////////////////////////
+I32 sign_extend(I32 value, std::size_t bits) {
+   I32 shift = I32(32 - bits);
+   return I32(U32(value) << shift) >> shift;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BC6H never produces infinities or NaNs, so every half can be converted by
+// moving its bits into place and rebiasing the exponent with a multiply
+// (which also normalizes denormals).
+F32 half_to_float(U16 half) {
+   U32 bits = U32(half & 0x7FFF) << 13;
+   F32 magnitude;
+   std::memcpy(&magnitude, &bits, sizeof(magnitude));
+   magnitude *= 5.192296858534828e+33f; // 2^112
+   return (half & 0x8000) ? -magnitude : magnitude;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void decode_bc6h(const UC* in, bool is_signed, F32 (&texels)[16][4]) {
+   BlockBitReader bits(in);
+
+   U32 mode_field = bits.read(2);
+   if (mode_field > 1) {
+      mode_field |= bits.read(3) << 2;
+   }
+
+   I8 mode_index = bc6h_mode_index[mode_field];
+   if (mode_index < 0) {
+      // reserved mode; decodes to black
+      for (auto& texel : texels) {
+         texel[0] = texel[1] = texel[2] = 0.f;
+         texel[3] = 1.f;
+      }
+      return;
+   }
+
+   const Bc6hMode& m = bc6h_modes[mode_index];
+
+   I32 endpoints[4][3] = { };
+   for (std::size_t s = 0; s < m.segment_count; ++s) {
+      const Bc6hSegment& seg = m.segments[s];
+      I32& field = endpoints[seg.field / 3][seg.field % 3];
+      if (seg.first_bit <= seg.last_bit) {
+         field |= I32(bits.read(seg.last_bit - seg.first_bit + 1u) << seg.first_bit);
+      } else {
+         for (std::size_t b = seg.first_bit + 1; b-- > seg.last_bit; ) {
+            field |= I32(bits.read(1) << b);
+         }
+      }
+   }
+
+   std::size_t partition = m.regions > 1 ? bits.read(5) : 0;
+   std::size_t count = m.regions * 2u;
+
+   for (std::size_t c = 0; c < 3; ++c) {
+      if (is_signed) {
+         endpoints[0][c] = sign_extend(endpoints[0][c], m.endpoint_bits);
+      }
+
+      for (std::size_t e = 1; e < count; ++e) {
+         I32& value = endpoints[e][c];
+         if (m.transformed) {
+            value = sign_extend(value, m.delta_bits[c]);
+            value = (endpoints[0][c] + value) & ((1 << m.endpoint_bits) - 1);
+         }
+         if (is_signed) {
+            value = sign_extend(value, m.endpoint_bits);
+         }
+      }
+
+      for (std::size_t e = 0; e < count; ++e) {
+         endpoints[e][c] = bc6h_unquantize(endpoints[e][c], m.endpoint_bits, is_signed);
+      }
+   }
+
+   std::size_t index_bits = m.regions > 1 ? 3 : 4;
+   std::size_t anchor = m.regions > 1 ? bptc_anchors2[partition] : 0;
+   const U8* weights = bptc_weights(index_bits);
+   U8 subsets[16];
+   bptc_subsets(m.regions, partition, subsets);
+   for (std::size_t i = 0; i < 16; ++i) {
+      U32 w = weights[bits.read(index_bits - (i == 0 || i == anchor ? 1 : 0))];
+      const I32* e0 = endpoints[subsets[i] * 2];
+      const I32* e1 = e0 + 3;
+      for (std::size_t c = 0; c < 3; ++c) {
+         I32 value = (I32(64 - w) * e0[c] + I32(w) * e1[c] + 32) >> 6;
+         texels[i][c] = half_to_float(bc6h_half_bits(bc6h_finish(value, is_signed)));
+      }
+      texels[i][3] = 1.f;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void store_block(const T (&texels)[16][4], UC* out, std::size_t line_span, std::size_t texel_span, I32 width, I32 height) {
+   for (I32 y = 0; y < height; ++y, out += line_span) {
+      UC* texel_out = out;
+      for (I32 x = 0; x < width; ++x, texel_out += texel_span) {
+         std::memcpy(texel_out, texels[y * 4 + x], sizeof(texels[0]));
+      }
+   }
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+bool can_decode_blocks(const ImageFormat& format) {
+   return block_codec(format) != BlockCodec::none;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void decode_block_rows(const ConstImageView& src, const ImageView& dest, I32 first_row, I32 rows) {
+   BlockCodec codec = block_codec(src.format());
+   if (codec == BlockCodec::none) {
+      return;
+   }
+
+   ivec3 dim = dest.dim();
+   I32 columns = (dim.x + 3) / 4;
+   I32 end_row = std::min((dim.y + 3) / 4, first_row + rows);
+
+   const UC* src_data = static_cast<const UC*>(src.data());
+   UC* dest_data = static_cast<UC*>(dest.data());
+   std::size_t texel_span = dest.block_span();
+
+   for (I32 z = 0; z < dim.z; ++z) {
+      for (I32 row = first_row; row < end_row; ++row) {
+         const UC* in = src_data + z * src.plane_span() + row * src.line_span();
+         I32 y0 = row * 4;
+         I32 height = std::min(4, dim.y - y0);
+
+         I32 column = 0;
+#ifdef BE_ATEX_BLOCK_DECODER_SSE2
+         if (codec >= BlockCodec::bc1 && codec <= BlockCodec::bc5) {
+            for (; column + 4 <= columns; column += 4, in += 4 * src.block_span()) {
+               U8 texels[4][16][4];
+               decode_s3tc_rgtc_x4(in, src.block_span(), codec, texels);
+               for (I32 b = 0; b < 4; ++b) {
+                  I32 x0 = (column + b) * 4;
+                  I32 width = std::min(4, dim.x - x0);
+                  UC* out = dest_data + z * dest.plane_span() + y0 * dest.line_span() + x0 * texel_span;
+                  store_block(texels[b], out, dest.line_span(), texel_span, width, height);
+               }
+            }
+         }
+#endif
+
+         for (; column < columns; ++column, in += src.block_span()) {
+            I32 x0 = column * 4;
+            I32 width = std::min(4, dim.x - x0);
+            UC* out = dest_data + z * dest.plane_span() + y0 * dest.line_span() + x0 * texel_span;
+
+            if (codec == BlockCodec::bc6h_unsigned || codec == BlockCodec::bc6h_signed) {
+               F32 texels[16][4];
+               decode_bc6h(in, codec == BlockCodec::bc6h_signed, texels);
+               store_block(texels, out, dest.line_span(), texel_span, width, height);
+               continue;
+            }
+
+            U8 texels[16][4];
+            switch (codec) {
+               case BlockCodec::bc1:
+                  decode_s3tc_color(in, false, texels);
+                  break;
+               case BlockCodec::bc2:
+                  decode_s3tc_color(in + 8, true, texels);
+                  decode_bc2_alpha(in, texels);
+                  break;
+               case BlockCodec::bc3:
+                  decode_s3tc_color(in + 8, true, texels);
+                  decode_rgtc_channel(in, 3, texels);
+                  break;
+               case BlockCodec::bc4:
+               case BlockCodec::bc5:
+                  for (auto& texel : texels) {
+                     texel[0] = texel[1] = texel[2] = 0;
+                     texel[3] = 255;
+                  }
+                  decode_rgtc_channel(in, 0, texels);
+                  if (codec == BlockCodec::bc5) {
+                     decode_rgtc_channel(in + 8, 1, texels);
+                  }
+                  break;
+               default:
+                  decode_bc7(in, texels);
+                  break;
+            }
+            store_block(texels, out, dest.line_span(), texel_span, width, height);
+         }
+      }
+   }
+}
+
+} // be::atex
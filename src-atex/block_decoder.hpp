@@ -0,0 +1,24 @@
+#pragma once
+#ifndef BE_ATEX_BLOCK_DECODER_HPP_
+#define BE_ATEX_BLOCK_DECODER_HPP_
+
+#include <be/gfx/tex/texture.hpp>
+
+namespace be::atex {
+
+// Returns true if decode_block_rows() can expand blocks in the given format.
+bool can_decode_blocks(const gfx::tex::ImageFormat& format);
+
+///////////////////////////////////////////////////////////////////////////////
+// Decodes block rows [first_row, first_row + rows) of src into the
+// corresponding pixels of dest.  dest must use block_codec_texel_format() of
+// src's format and have the same pixel dimensions as src.  Disjoint ranges
+// of block rows of the same image may be decoded concurrently.
+//
+// All modes of BC1-BC5, BC6H, and BC7 are supported.
+void decode_block_rows(const gfx::tex::ConstImageView& src, const gfx::tex::ImageView& dest,
+                       I32 first_row, I32 rows);
+
+} // be::atex
+
+#endif
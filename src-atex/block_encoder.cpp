@@ -0,0 +1,872 @@
+#include "block_encoder.hpp"
+#include "block_codec.hpp"
+#include "working_image.hpp"
+#include <be/gfx/tex/blit_pixels.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace be::atex {
+namespace {
+
+using namespace gfx::tex;
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of least-squares endpoint refinement passes for each quality level.
+int refine_iterations(EncodeQuality quality) {
+   switch (quality) {
+      case EncodeQuality::fast: return 0;
+      case EncodeQuality::best: return 8;
+      default:                  return 2;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Picks a starting line segment through the active texels.  For fast
+// encoding this is the diagonal of their bounding box, oriented so that each
+// channel agrees with the channel that varies the most; otherwise it is
+// their extent along the principal axis of their distribution.
+template <std::size_t C>
+void initial_endpoints(const F32 (&texels)[16][C], const bool* active, bool pca, F32 lo, F32 hi, F32 (&e0)[C], F32 (&e1)[C]) {
+   F32 mean[C] = { };
+   F32 min[C];
+   F32 max[C];
+   std::fill_n(min, C, std::numeric_limits<F32>::max());
+   std::fill_n(max, C, std::numeric_limits<F32>::lowest());
+
+   std::size_t count = 0;
+   for (std::size_t i = 0; i < 16; ++i) {
+      if (active && !active[i]) {
+         continue;
+      }
+      ++count;
+      for (std::size_t c = 0; c < C; ++c) {
+         mean[c] += texels[i][c];
+         min[c] = std::min(min[c], texels[i][c]);
+         max[c] = std::max(max[c], texels[i][c]);
+      }
+   }
+
+   if (count == 0) {
+      std::fill_n(e0, C, lo);
+      std::fill_n(e1, C, lo);
+      return;
+   }
+
+   for (std::size_t c = 0; c < C; ++c) {
+      mean[c] /= F32(count);
+   }
+
+   F32 cov[C][C] = { };
+   for (std::size_t i = 0; i < 16; ++i) {
+      if (active && !active[i]) {
+         continue;
+      }
+      F32 d[C];
+      for (std::size_t c = 0; c < C; ++c) {
+         d[c] = texels[i][c] - mean[c];
+      }
+      for (std::size_t a = 0; a < C; ++a) {
+         for (std::size_t b = 0; b < C; ++b) {
+            cov[a][b] += d[a] * d[b];
+         }
+      }
+   }
+
+   if (!pca) {
+      std::size_t major = 0;
+      for (std::size_t c = 1; c < C; ++c) {
+         if (max[c] - min[c] > max[major] - min[major]) {
+            major = c;
+         }
+      }
+      for (std::size_t c = 0; c < C; ++c) {
+         bool flip = cov[c][major] < 0.f;
+         e0[c] = flip ? max[c] : min[c];
+         e1[c] = flip ? min[c] : max[c];
+      }
+      return;
+   }
+
+   F32 axis[C];
+   F32 length = 0.f;
+   for (std::size_t c = 0; c < C; ++c) {
+      axis[c] = max[c] - min[c];
+      length += axis[c] * axis[c];
+   }
+
+   if (length > 0.f) {
+      for (int iteration = 0; iteration < 8; ++iteration) {
+         F32 next[C] = { };
+         F32 largest = 0.f;
+         for (std::size_t a = 0; a < C; ++a) {
+            for (std::size_t b = 0; b < C; ++b) {
+               next[a] += cov[a][b] * axis[b];
+            }
+            largest = std::max(largest, std::abs(next[a]));
+         }
+         if (largest <= 0.f) {
+            break;
+         }
+         for (std::size_t c = 0; c < C; ++c) {
+            axis[c] = next[c] / largest;
+         }
+      }
+
+      length = 0.f;
+      for (std::size_t c = 0; c < C; ++c) {
+         length += axis[c] * axis[c];
+      }
+   }
+
+   if (length <= 0.f) {
+      for (std::size_t c = 0; c < C; ++c) {
+         e0[c] = e1[c] = mean[c];
+      }
+      return;
+   }
+
+   length = std::sqrt(length);
+   for (std::size_t c = 0; c < C; ++c) {
+      axis[c] /= length;
+   }
+
+   F32 tmin = std::numeric_limits<F32>::max();
+   F32 tmax = std::numeric_limits<F32>::lowest();
+   for (std::size_t i = 0; i < 16; ++i) {
+      if (active && !active[i]) {
+         continue;
+      }
+      F32 t = 0.f;
+      for (std::size_t c = 0; c < C; ++c) {
+         t += (texels[i][c] - mean[c]) * axis[c];
+      }
+      tmin = std::min(tmin, t);
+      tmax = std::max(tmax, t);
+   }
+
+   for (std::size_t c = 0; c < C; ++c) {
+      e0[c] = std::clamp(mean[c] + axis[c] * tmin, lo, hi);
+      e1[c] = std::clamp(mean[c] + axis[c] * tmax, lo, hi);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Selects the closest usable palette entry for each active texel.
+template <typename Codec>
+void assign_indices(const F32 (&texels)[16][Codec::channels], const bool* active, typename Codec::Block& block) {
+   F32 error = 0.f;
+   for (std::size_t i = 0; i < 16; ++i) {
+      if (active && !active[i]) {
+         continue;
+      }
+      F32 best = std::numeric_limits<F32>::max();
+      U8 best_index = 0;
+      for (std::size_t n = 0; n < block.levels; ++n) {
+         F32 d = 0.f;
+         for (std::size_t c = 0; c < Codec::channels; ++c) {
+            F32 delta = texels[i][c] - block.palette[n][c];
+            d += delta * delta;
+         }
+         if (d < best) {
+            best = d;
+            best_index = U8(n);
+         }
+      }
+      block.indices[i] = best_index;
+      error += best;
+   }
+   block.error = error;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Solves for the unquantized endpoints which minimize the squared error of
+// the active texels, given their current palette indices.
+template <typename Codec>
+bool refine_endpoints(const F32 (&texels)[16][Codec::channels], const bool* active, const typename Codec::Block& block,
+                      F32 (&e0)[Codec::channels], F32 (&e1)[Codec::channels]) {
+   constexpr std::size_t C = Codec::channels;
+   F32 aa = 0.f, bb = 0.f, ab = 0.f;
+   F32 ax[C] = { };
+   F32 bx[C] = { };
+   for (std::size_t i = 0; i < 16; ++i) {
+      if (active && !active[i]) {
+         continue;
+      }
+      F32 w = Codec::weights[block.indices[i]];
+      F32 a = 1.f - w;
+      aa += a * a;
+      bb += w * w;
+      ab += a * w;
+      for (std::size_t c = 0; c < C; ++c) {
+         ax[c] += a * texels[i][c];
+         bx[c] += w * texels[i][c];
+      }
+   }
+
+   F32 det = aa * bb - ab * ab;
+   if (std::abs(det) < 1e-6f) {
+      return false;
+   }
+
+   F32 inv_det = 1.f / det;
+   for (std::size_t c = 0; c < C; ++c) {
+      e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) * inv_det, Codec::range_min, Codec::range_max);
+      e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) * inv_det, Codec::range_min, Codec::range_max);
+   }
+   return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename Codec>
+typename Codec::Block fit_block(const F32 (&texels)[16][Codec::channels], const bool* active, EncodeQuality quality) {
+   F32 e0[Codec::channels];
+   F32 e1[Codec::channels];
+   initial_endpoints(texels, active, quality != EncodeQuality::fast, Codec::range_min, Codec::range_max, e0, e1);
+
+   typename Codec::Block best;
+   Codec::quantize(e0, e1, best);
+   assign_indices<Codec>(texels, active, best);
+
+   for (int iteration = refine_iterations(quality); iteration > 0 && best.error > 0.f; --iteration) {
+      if (!refine_endpoints<Codec>(texels, active, best, e0, e1)) {
+         break;
+      }
+
+      typename Codec::Block candidate;
+      Codec::quantize(e0, e1, candidate);
+      assign_indices<Codec>(texels, active, candidate);
+      if (candidate.error >= best.error) {
+         break;
+      }
+      best = candidate;
+   }
+
+   return best;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U16 pack_565(const F32* rgb) {
+   U32 r = U32(std::clamp(std::lround(rgb[0] * (31.f / 255.f)), 0l, 31l));
+   U32 g = U32(std::clamp(std::lround(rgb[1] * (63.f / 255.f)), 0l, 63l));
+   U32 b = U32(std::clamp(std::lround(rgb[2] * (31.f / 255.f)), 0l, 31l));
+   return U16((r << 11) | (g << 5) | b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// S3TC color block.  BC1 blocks must have c0 > c1 to select the 4-color
+// palette; BC2/BC3 blocks always use it.
+template <bool Bc1>
+struct S3tcColor {
+   static constexpr std::size_t channels = 3;
+   static constexpr F32 range_min = 0.f;
+   static constexpr F32 range_max = 255.f;
+   static constexpr F32 weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+   struct Block {
+      U16 c0 = 0;
+      U16 c1 = 0;
+      F32 palette[4][3];
+      std::size_t levels = 4;
+      U8 indices[16] = { };
+      F32 error = 0.f;
+   };
+
+   static void quantize(const F32 (&e0)[3], const F32 (&e1)[3], Block& block) {
+      block.c0 = pack_565(e0);
+      block.c1 = pack_565(e1);
+      if (Bc1 && block.c0 < block.c1) {
+         std::swap(block.c0, block.c1);
+      }
+
+      U8 palette[4][4];
+      s3tc_palette(block.c0, block.c1, !Bc1, palette);
+      for (std::size_t n = 0; n < 4; ++n) {
+         for (std::size_t c = 0; c < 3; ++c) {
+            block.palette[n][c] = palette[n][c];
+         }
+      }
+      // if c0 == c1 a BC1 block is in 3-color mode, so index 3 is black
+      block.levels = Bc1 && block.c0 == block.c1 ? 3 : 4;
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// BC1 3-color mode; index 3 is reserved for transparent texels.
+struct S3tcColorPunchThrough {
+   static constexpr std::size_t channels = 3;
+   static constexpr F32 range_min = 0.f;
+   static constexpr F32 range_max = 255.f;
+   static constexpr F32 weights[4] = { 0.f, 1.f, 0.5f, 0.f };
+
+   struct Block {
+      U16 c0 = 0;
+      U16 c1 = 0;
+      F32 palette[3][3];
+      std::size_t levels = 3;
+      U8 indices[16] = { };
+      F32 error = 0.f;
+   };
+
+   static void quantize(const F32 (&e0)[3], const F32 (&e1)[3], Block& block) {
+      block.c0 = pack_565(e0);
+      block.c1 = pack_565(e1);
+      if (block.c0 > block.c1) {
+         std::swap(block.c0, block.c1);
+      }
+
+      U8 palette[4][4];
+      s3tc_palette(block.c0, block.c1, false, palette);
+      for (std::size_t n = 0; n < 3; ++n) {
+         for (std::size_t c = 0; c < 3; ++c) {
+            block.palette[n][c] = palette[n][c];
+         }
+      }
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// BC7 mode 6: one subset, RGBA endpoints with 7 bits per channel plus a
+// unique p-bit (shared LSB) per endpoint, and 4-bit indices.
+struct Bc7Mode6 {
+   static constexpr std::size_t channels = 4;
+   static constexpr F32 range_min = 0.f;
+   static constexpr F32 range_max = 255.f;
+   static constexpr F32 weights[16] = {
+      0 / 64.f, 4 / 64.f, 9 / 64.f, 13 / 64.f, 17 / 64.f, 21 / 64.f, 26 / 64.f, 30 / 64.f,
+      34 / 64.f, 38 / 64.f, 43 / 64.f, 47 / 64.f, 51 / 64.f, 55 / 64.f, 60 / 64.f, 64 / 64.f
+   };
+
+   struct Block {
+      U8 e[2][4] = { };
+      U8 p[2] = { };
+      F32 palette[16][4];
+      std::size_t levels = 16;
+      U8 indices[16] = { };
+      F32 error = 0.f;
+   };
+
+   static void quantize_endpoint(const F32 (&value)[4], U8 (&e)[4], U8& p) {
+      F32 best_error = std::numeric_limits<F32>::max();
+      for (U8 pbit = 0; pbit < 2; ++pbit) {
+         U8 q[4];
+         F32 error = 0.f;
+         for (std::size_t c = 0; c < 4; ++c) {
+            q[c] = U8(std::clamp(std::lround((value[c] - pbit) * 0.5f), 0l, 127l));
+            F32 delta = value[c] - F32((q[c] << 1) | pbit);
+            error += delta * delta;
+         }
+         if (error < best_error) {
+            best_error = error;
+            std::copy(q, q + 4, e);
+            p = pbit;
+         }
+      }
+   }
+
+   static void quantize(const F32 (&e0)[4], const F32 (&e1)[4], Block& block) {
+      quantize_endpoint(e0, block.e[0], block.p[0]);
+      quantize_endpoint(e1, block.e[1], block.p[1]);
+
+      for (std::size_t c = 0; c < 4; ++c) {
+         U32 a = U32((block.e[0][c] << 1) | block.p[0]);
+         U32 b = U32((block.e[1][c] << 1) | block.p[1]);
+         for (std::size_t n = 0; n < 16; ++n) {
+            U32 w = bptc_weights4[n];
+            block.palette[n][c] = F32(((64 - w) * a + w * b + 32) >> 6);
+         }
+      }
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// BC6H mode 11: one region, 10-bit endpoints with no transform, and 4-bit
+// indices.  Texels are fitted in the domain of half-float bit patterns
+// (magnitude, negated for negative values) since that is the domain the
+// hardware interpolates in.
+template <bool Signed>
+struct Bc6hMode11 {
+   static constexpr std::size_t channels = 3;
+   static constexpr F32 range_min = Signed ? -F32(0x7BFF) : 0.f;
+   static constexpr F32 range_max = F32(0x7BFF);
+   static constexpr F32 weights[16] = {
+      0 / 64.f, 4 / 64.f, 9 / 64.f, 13 / 64.f, 17 / 64.f, 21 / 64.f, 26 / 64.f, 30 / 64.f,
+      34 / 64.f, 38 / 64.f, 43 / 64.f, 47 / 64.f, 51 / 64.f, 55 / 64.f, 60 / 64.f, 64 / 64.f
+   };
+
+   struct Block {
+      I32 e[2][3] = { };
+      F32 palette[16][3];
+      std::size_t levels = 16;
+      U8 indices[16] = { };
+      F32 error = 0.f;
+   };
+
+   static I32 decode_endpoint(I32 e) {
+      return bc6h_finish(bc6h_unquantize(e, 10, Signed), Signed);
+   }
+
+   static I32 quantize_value(F32 value) {
+      constexpr I32 min = Signed ? -511 : 0;
+      constexpr I32 max = Signed ? 511 : 1023;
+      constexpr F32 step = Signed ? 62.f : 31.f;
+      F32 magnitude = std::max(std::abs(value) - step * 0.5f, 0.f) / step;
+      I32 guess = I32(std::lround(value < 0.f ? -magnitude : magnitude));
+
+      I32 best = std::clamp(guess, min, max);
+      F32 best_error = std::abs(F32(decode_endpoint(best)) - value);
+      for (I32 e = std::max(guess - 1, min); e <= std::min(guess + 1, max); ++e) {
+         F32 error = std::abs(F32(decode_endpoint(e)) - value);
+         if (error < best_error) {
+            best_error = error;
+            best = e;
+         }
+      }
+      return best;
+   }
+
+   static void quantize(const F32 (&e0)[3], const F32 (&e1)[3], Block& block) {
+      for (std::size_t c = 0; c < 3; ++c) {
+         block.e[0][c] = quantize_value(e0[c]);
+         block.e[1][c] = quantize_value(e1[c]);
+
+         I32 a = bc6h_unquantize(block.e[0][c], 10, Signed);
+         I32 b = bc6h_unquantize(block.e[1][c], 10, Signed);
+         for (std::size_t n = 0; n < 16; ++n) {
+            I32 w = bptc_weights4[n];
+            block.palette[n][c] = F32(bc6h_finish((a * (64 - w) + b * w + 32) >> 6, Signed));
+         }
+      }
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+void write_s3tc_color(U16 c0, U16 c1, const U8 (&indices)[16], UC* out) {
+   out[0] = UC(c0 & 0xFF);
+   out[1] = UC(c0 >> 8);
+   out[2] = UC(c1 & 0xFF);
+   out[3] = UC(c1 >> 8);
+   U32 bits = 0;
+   for (std::size_t i = 0; i < 16; ++i) {
+      bits |= U32(indices[i]) << (i * 2);
+   }
+   for (std::size_t i = 0; i < 4; ++i) {
+      out[4 + i] = UC(bits >> (i * 8));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename Block>
+void write_s3tc_color(const Block& block, UC* out) {
+   write_s3tc_color(block.c0, block.c1, block.indices, out);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// For each 8-bit value, the pair of 5-bit (or 6-bit) endpoints whose first
+// interpolated palette entry is closest to it.  Solid-color blocks use these
+// since the interpolated entries can represent colors that endpoints can't.
+struct SingleColorEntry {
+   U8 e0;
+   U8 e1;
+};
+
+const SingleColorEntry* single_color_table(U32 bits) {
+   static const auto tables = []() {
+      std::array<std::array<SingleColorEntry, 256>, 2> result;
+      for (std::size_t t = 0; t < 2; ++t) {
+         U32 max = t ? 63 : 31;
+         auto expand = [t](U32 e) { return t ? (e << 2) | (e >> 4) : (e << 3) | (e >> 2); };
+         for (U32 v = 0; v < 256; ++v) {
+            U32 best_error = std::numeric_limits<U32>::max();
+            for (U32 a = 0; a <= max; ++a) {
+               for (U32 b = 0; b <= max; ++b) {
+                  I32 interp = I32((2 * expand(a) + expand(b) + 1) / 3);
+                  // prefer close endpoints, so that other decoders' rounding doesn't matter much
+                  U32 error = U32(std::abs(interp - I32(v))) * 1024 + U32(std::abs(I32(a) - I32(b)));
+                  if (error < best_error) {
+                     best_error = error;
+                     result[t][v] = SingleColorEntry { U8(a), U8(b) };
+                  }
+               }
+            }
+         }
+      }
+      return result;
+   }();
+   return tables[bits == 6 ? 1 : 0].data();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void encode_s3tc_solid_color(const U8 (&rgb)[4], bool bc1, UC* out) {
+   const SingleColorEntry& r = single_color_table(5)[rgb[0]];
+   const SingleColorEntry& g = single_color_table(6)[rgb[1]];
+   const SingleColorEntry& b = single_color_table(5)[rgb[2]];
+   U16 c0 = U16((r.e0 << 11) | (g.e0 << 5) | b.e0);
+   U16 c1 = U16((r.e1 << 11) | (g.e1 << 5) | b.e1);
+
+   U8 index = 2;
+   if (bc1 && c0 < c1) {
+      std::swap(c0, c1);
+      index = 3;
+   }
+   if (c0 == c1) {
+      index = 0;
+   }
+
+   U8 indices[16];
+   std::fill_n(indices, 16, index);
+   write_s3tc_color(c0, c1, indices, out);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void encode_s3tc_color(const U8 (&rgba)[16][4], bool bc1, bool punch_through, EncodeQuality quality, UC* out) {
+   F32 texels[16][3];
+   bool active[16];
+   bool any_transparent = false;
+   for (std::size_t i = 0; i < 16; ++i) {
+      for (std::size_t c = 0; c < 3; ++c) {
+         texels[i][c] = rgba[i][c];
+      }
+      active[i] = !punch_through || rgba[i][3] >= 128;
+      any_transparent = any_transparent || !active[i];
+   }
+
+   bool solid = !any_transparent;
+   for (std::size_t i = 1; i < 16 && solid; ++i) {
+      solid = std::equal(rgba[i], rgba[i] + 3, rgba[0]);
+   }
+
+   if (solid) {
+      encode_s3tc_solid_color(rgba[0], bc1, out);
+   } else if (!bc1) {
+      write_s3tc_color(fit_block<S3tcColor<false>>(texels, nullptr, quality), out);
+   } else if (any_transparent) {
+      auto block = fit_block<S3tcColorPunchThrough>(texels, active, quality);
+      for (std::size_t i = 0; i < 16; ++i) {
+         if (!active[i]) {
+            block.indices[i] = 3;
+         }
+      }
+      write_s3tc_color(block, out);
+   } else {
+      auto block = fit_block<S3tcColor<true>>(texels, nullptr, quality);
+      if (quality == EncodeQuality::best && block.error > 0.f) {
+         // the 3-color palette's midpoint is occasionally a better fit
+         auto alt = fit_block<S3tcColorPunchThrough>(texels, nullptr, quality);
+         if (alt.error < block.error) {
+            write_s3tc_color(alt, out);
+            return;
+         }
+      }
+      write_s3tc_color(block, out);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U32 rgtc_error(const U8 (&values)[16], U8 e0, U8 e1, U8 (&indices)[16]) {
+   U8 palette[8];
+   rgtc_palette(e0, e1, palette);
+   U32 error = 0;
+   for (std::size_t i = 0; i < 16; ++i) {
+      U32 best = std::numeric_limits<U32>::max();
+      for (std::size_t n = 0; n < 8; ++n) {
+         I32 delta = I32(values[i]) - I32(palette[n]);
+         U32 d = U32(delta * delta);
+         if (d < best) {
+            best = d;
+            indices[i] = U8(n);
+         }
+      }
+      error += best;
+   }
+   return error;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Encodes a BC4 block, or the alpha half of a BC3 block.  Better quality
+// levels also try the 6-value palette (which has exact 0 and 255 entries) and
+// search a small neighborhood of endpoints around the extremes.
+void encode_rgtc(const U8 (&values)[16], EncodeQuality quality, UC* out) {
+   U8 lo = 255;
+   U8 hi = 0;
+   U8 lo6 = 255;
+   U8 hi6 = 0;
+   for (U8 v : values) {
+      lo = std::min(lo, v);
+      hi = std::max(hi, v);
+      if (v != 0 && v != 255) {
+         lo6 = std::min(lo6, v);
+         hi6 = std::max(hi6, v);
+      }
+   }
+
+   U8 best_e0 = hi;
+   U8 best_e1 = lo;
+   U8 best_indices[16];
+   U32 best_error = rgtc_error(values, hi, lo, best_indices);
+
+   auto consider = [&](U8 e0, U8 e1) {
+      U8 indices[16];
+      U32 error = rgtc_error(values, e0, e1, indices);
+      if (error < best_error) {
+         best_error = error;
+         best_e0 = e0;
+         best_e1 = e1;
+         std::copy(indices, indices + 16, best_indices);
+      }
+   };
+
+   if (quality != EncodeQuality::fast && best_error > 0) {
+      if (lo6 <= hi6) {
+         consider(lo6, hi6);
+      }
+
+      int radius = quality == EncodeQuality::best ? 4 : 1;
+      for (int d0 = 0; d0 <= radius && best_error > 0; ++d0) {
+         for (int d1 = 0; d1 <= radius; ++d1) {
+            int e0 = int(hi) - d0;
+            int e1 = int(lo) + d1;
+            if (e0 > e1) {
+               consider(U8(e0), U8(e1));
+            }
+         }
+      }
+   }
+
+   out[0] = best_e0;
+   out[1] = best_e1;
+   U64 bits = 0;
+   for (std::size_t i = 0; i < 16; ++i) {
+      bits |= U64(best_indices[i]) << (i * 3);
+   }
+   for (std::size_t i = 0; i < 6; ++i) {
+      out[2 + i] = UC(bits >> (i * 8));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void encode_bc2_alpha(const U8 (&rgba)[16][4], UC* out) {
+   U64 bits = 0;
+   for (std::size_t i = 0; i < 16; ++i) {
+      bits |= U64((rgba[i][3] * 15u + 127u) / 255u) << (i * 4);
+   }
+   for (std::size_t i = 0; i < 8; ++i) {
+      out[i] = UC(bits >> (i * 8));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void encode_rgtc_channel(const U8 (&rgba)[16][4], std::size_t channel, EncodeQuality quality, UC* out) {
+   U8 values[16];
+   for (std::size_t i = 0; i < 16; ++i) {
+      values[i] = rgba[i][channel];
+   }
+   encode_rgtc(values, quality, out);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void encode_bc7(const U8 (&rgba)[16][4], EncodeQuality quality, UC* out) {
+   F32 texels[16][4];
+   for (std::size_t i = 0; i < 16; ++i) {
+      for (std::size_t c = 0; c < 4; ++c) {
+         texels[i][c] = rgba[i][c];
+      }
+   }
+
+   Bc7Mode6::Block block = fit_block<Bc7Mode6>(texels, nullptr, quality);
+
+   // the MSB of the first index is implicitly 0
+   if (block.indices[0] & 8) {
+      std::swap(block.e[0], block.e[1]);
+      std::swap(block.p[0], block.p[1]);
+      for (U8& index : block.indices) {
+         index = U8(15 - index);
+      }
+   }
+
+   BlockBitWriter writer;
+   writer.write(1u << 6, 7);
+   for (std::size_t c = 0; c < 4; ++c) {
+      writer.write(block.e[0][c], 7);
+      writer.write(block.e[1][c], 7);
+   }
+   writer.write(block.p[0], 1);
+   writer.write(block.p[1], 1);
+   writer.write(block.indices[0], 3);
+   for (std::size_t i = 1; i < 16; ++i) {
+      writer.write(block.indices[i], 4);
+   }
+   std::memcpy(out, writer.data(), 16);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+F32 bc6h_domain_value(F32 value, bool is_signed) {
+   if (std::isnan(value)) {
+      return 0.f;
+   }
+   value = std::clamp(value, is_signed ? -65504.f : 0.f, 65504.f);
+   I32 magnitude = I32(glm::packHalf1x16(std::abs(value)) & 0x7FFF);
+   magnitude = std::min(magnitude, 0x7BFF);
+   return F32(value < 0.f ? -magnitude : magnitude);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <bool Signed>
+void encode_bc6h(const F32 (&rgba)[16][4], EncodeQuality quality, UC* out) {
+   F32 texels[16][3];
+   for (std::size_t i = 0; i < 16; ++i) {
+      for (std::size_t c = 0; c < 3; ++c) {
+         texels[i][c] = bc6h_domain_value(rgba[i][c], Signed);
+      }
+   }
+
+   typename Bc6hMode11<Signed>::Block block = fit_block<Bc6hMode11<Signed>>(texels, nullptr, quality);
+
+   // the MSB of the first index is implicitly 0
+   if (block.indices[0] & 8) {
+      std::swap(block.e[0], block.e[1]);
+      for (U8& index : block.indices) {
+         index = U8(15 - index);
+      }
+   }
+
+   BlockBitWriter writer;
+   writer.write(0x03, 5);
+   for (std::size_t e = 0; e < 2; ++e) {
+      for (std::size_t c = 0; c < 3; ++c) {
+         writer.write(U32(block.e[e][c]) & 0x3FF, 10);
+      }
+   }
+   writer.write(block.indices[0], 3);
+   for (std::size_t i = 1; i < 16; ++i) {
+      writer.write(block.indices[i], 4);
+   }
+   std::memcpy(out, writer.data(), 16);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reads the 4x4 block at the specified block coordinates, replicating the
+// last row/column for partial blocks at the right and bottom edges.
+template <typename T>
+void gather_block(const WorkingImage& image, I32 column, I32 row, I32 z, bool opaque, T (&texels)[16][4]) {
+   ivec3 dim = image.dim();
+   for (I32 ty = 0; ty < 4; ++ty) {
+      I32 y = std::min(row * 4 + ty, dim.y - 1);
+      const T* line = image.line<T>(y, z);
+      for (I32 tx = 0; tx < 4; ++tx) {
+         I32 x = std::min(column * 4 + tx, dim.x - 1);
+         std::copy(line + x * 4, line + x * 4 + 4, texels[ty * 4 + tx]);
+         if (opaque) {
+            texels[ty * 4 + tx][3] = std::is_floating_point<T>::value ? T(1) : T(255);
+         }
+      }
+   }
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+const char* encode_quality_name(EncodeQuality quality) {
+   switch (quality) {
+      case EncodeQuality::fast:   return "fast";
+      case EncodeQuality::normal: return "normal";
+      case EncodeQuality::best:   return "best";
+      default:                    return "?";
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool parse_encode_quality(const S& name, EncodeQuality& quality) {
+   for (EncodeQuality q : { EncodeQuality::fast, EncodeQuality::normal, EncodeQuality::best }) {
+      if (name == encode_quality_name(q)) {
+         quality = q;
+         return true;
+      }
+   }
+   return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool can_encode_blocks(const ImageFormat& format) {
+   return block_codec(format) != BlockCodec::none;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void encode_block_rows(const ConstImageView& src, const ImageView& dest, I32 first_row, I32 rows, EncodeQuality quality) {
+   ImageFormat format = dest.format();
+   BlockCodec codec = block_codec(format);
+   if (codec == BlockCodec::none) {
+      return;
+   }
+
+   ivec3 dim = src.dim();
+   I32 y0 = first_row * 4;
+   I32 y1 = std::min(dim.y, (first_row + rows) * 4);
+   if (y0 >= y1) {
+      return;
+   }
+
+   // convert just this band of rows to the codec's texel format
+   WorkingImage band(ivec3(dim.x, y1 - y0, dim.z), block_codec_texel_format(format));
+   auto src_extents = pixel_region(src).extents();
+   src_extents.offset.y += y0;
+   src_extents.dim.y = y1 - y0;
+   blit_pixels(src, ImageRegion(src_extents), band.image(), pixel_region(band.image()));
+
+   bool opaque = format.components() < 4;
+   I32 columns = (dim.x + 3) / 4;
+   I32 band_rows = (y1 - y0 + 3) / 4;
+   UC* dest_data = static_cast<UC*>(dest.data());
+
+   for (I32 z = 0; z < dim.z; ++z) {
+      for (I32 row = 0; row < band_rows; ++row) {
+         UC* out = dest_data + z * dest.plane_span() + (first_row + row) * dest.line_span();
+         for (I32 column = 0; column < columns; ++column, out += dest.block_span()) {
+            if (codec == BlockCodec::bc6h_unsigned || codec == BlockCodec::bc6h_signed) {
+               F32 texels[16][4];
+               gather_block(band, column, row, z, opaque, texels);
+               if (codec == BlockCodec::bc6h_signed) {
+                  encode_bc6h<true>(texels, quality, out);
+               } else {
+                  encode_bc6h<false>(texels, quality, out);
+               }
+               continue;
+            }
+
+            U8 texels[16][4];
+            gather_block(band, column, row, z, opaque, texels);
+            switch (codec) {
+               case BlockCodec::bc1:
+                  encode_s3tc_color(texels, true, !opaque, quality, out);
+                  break;
+               case BlockCodec::bc2:
+                  encode_bc2_alpha(texels, out);
+                  encode_s3tc_color(texels, false, false, quality, out + 8);
+                  break;
+               case BlockCodec::bc3:
+                  encode_rgtc_channel(texels, 3, quality, out);
+                  encode_s3tc_color(texels, false, false, quality, out + 8);
+                  break;
+               case BlockCodec::bc4:
+                  encode_rgtc_channel(texels, 0, quality, out);
+                  break;
+               case BlockCodec::bc5:
+                  encode_rgtc_channel(texels, 0, quality, out);
+                  encode_rgtc_channel(texels, 1, quality, out + 8);
+                  break;
+               case BlockCodec::bc7:
+                  encode_bc7(texels, quality, out);
+                  break;
+               default:
+                  break;
+            }
+         }
+      }
+   }
+}
+
+} // be::atex
@@ -0,0 +1,36 @@
+#pragma once
+#ifndef BE_ATEX_BLOCK_ENCODER_HPP_
+#define BE_ATEX_BLOCK_ENCODER_HPP_
+
+#include <be/gfx/tex/texture.hpp>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+enum class EncodeQuality : U8 {
+   fast,
+   normal,
+   best
+};
+
+const char* encode_quality_name(EncodeQuality quality);
+bool parse_encode_quality(const S& name, EncodeQuality& quality);
+
+// Returns true if encode_block_rows() can produce blocks in the given format.
+bool can_encode_blocks(const gfx::tex::ImageFormat& format);
+
+///////////////////////////////////////////////////////////////////////////////
+// Encodes block rows [first_row, first_row + rows) of dest from the
+// corresponding pixels of src.  src must be uncompressed and have the same
+// pixel dimensions as dest.  Disjoint ranges of block rows of the same image
+// may be encoded concurrently.
+//
+// Supported formats are BC1-BC5, BC6H (using only mode 11: a single region
+// with 10-bit endpoints), and BC7 (using only mode 6: a single region with
+// 7-bit RGBA endpoints + p-bits).
+void encode_block_rows(const gfx::tex::ConstImageView& src, const gfx::tex::ImageView& dest,
+                       I32 first_row, I32 rows, EncodeQuality quality);
+
+} // be::atex
+
+#endif
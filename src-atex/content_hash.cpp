@@ -0,0 +1,125 @@
+#include "content_hash.hpp"
+#include <cstring>
+
+namespace be::atex {
+namespace {
+
+constexpr U64 prime1 = 0x9E3779B185EBCA87ull;
+constexpr U64 prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr U64 prime3 = 0x165667B19E3779F9ull;
+constexpr U64 prime4 = 0x85EBCA77C2B2AE63ull;
+constexpr U64 prime5 = 0x27D4EB2F165667C5ull;
+
+///////////////////////////////////////////////////////////////////////////////
+U64 rotl(U64 x, int r) {
+   return (x << r) | (x >> (64 - r));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U64 read_u64(const U8* p) {
+   U64 v = 0;
+   for (int i = 7; i >= 0; --i) {
+      v = (v << 8) | p[i];
+   }
+   return v;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U32 read_u32(const U8* p) {
+   return U32(p[0]) | (U32(p[1]) << 8) | (U32(p[2]) << 16) | (U32(p[3]) << 24);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U64 round(U64 acc, U64 input) {
+   acc += input * prime2;
+   acc = rotl(acc, 31);
+   return acc * prime1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U64 merge_round(U64 acc, U64 val) {
+   acc ^= round(0, val);
+   return acc * prime1 + prime4;
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+ContentHash::ContentHash(U64 seed)
+   : acc_ { seed + prime1 + prime2, seed + prime2, seed, seed - prime1 },
+     seed_(seed) { }
+
+///////////////////////////////////////////////////////////////////////////////
+void ContentHash::update(const void* data, std::size_t size) {
+   const U8* p = static_cast<const U8*>(data);
+   const U8* end = p + size;
+   total_size_ += size;
+
+   if (buf_size_ + size < sizeof(buf_)) {
+      std::memcpy(buf_ + buf_size_, p, size);
+      buf_size_ += size;
+      return;
+   }
+
+   if (buf_size_ > 0) {
+      std::size_t fill = sizeof(buf_) - buf_size_;
+      std::memcpy(buf_ + buf_size_, p, fill);
+      p += fill;
+      for (int i = 0; i < 4; ++i) {
+         acc_[i] = round(acc_[i], read_u64(buf_ + i * 8));
+      }
+      buf_size_ = 0;
+   }
+
+   while (end - p >= 32) {
+      for (int i = 0; i < 4; ++i) {
+         acc_[i] = round(acc_[i], read_u64(p + i * 8));
+      }
+      p += 32;
+   }
+
+   buf_size_ = std::size_t(end - p);
+   std::memcpy(buf_, p, buf_size_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U64 ContentHash::digest() const {
+   U64 h;
+   if (total_size_ >= 32) {
+      h = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) + rotl(acc_[3], 18);
+      for (int i = 0; i < 4; ++i) {
+         h = merge_round(h, acc_[i]);
+      }
+   } else {
+      h = seed_ + prime5;
+   }
+
+   h += total_size_;
+
+   const U8* p = buf_;
+   const U8* end = buf_ + buf_size_;
+   while (end - p >= 8) {
+      h ^= round(0, read_u64(p));
+      h = rotl(h, 27) * prime1 + prime4;
+      p += 8;
+   }
+   if (end - p >= 4) {
+      h ^= U64(read_u32(p)) * prime1;
+      h = rotl(h, 23) * prime2 + prime3;
+      p += 4;
+   }
+   while (p < end) {
+      h ^= U64(*p) * prime5;
+      h = rotl(h, 11) * prime1;
+      ++p;
+   }
+
+   h ^= h >> 33;
+   h *= prime2;
+   h ^= h >> 29;
+   h *= prime3;
+   h ^= h >> 32;
+   return h;
+}
+
+} // be::atex
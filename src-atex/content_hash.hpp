@@ -0,0 +1,30 @@
+#pragma once
+#ifndef BE_ATEX_CONTENT_HASH_HPP_
+#define BE_ATEX_CONTENT_HASH_HPP_
+
+#include <be/core/be.hpp>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+// Incremental XXH64 hash.  Produces the same digests as the reference
+// implementation, regardless of how the input is split between update()
+// calls.
+class ContentHash final {
+public:
+   explicit ContentHash(U64 seed = 0);
+
+   void update(const void* data, std::size_t size);
+   U64 digest() const;
+
+private:
+   U64 acc_[4];
+   U64 seed_;
+   U64 total_size_ = 0;
+   U8 buf_[32];
+   std::size_t buf_size_ = 0;
+};
+
+} // be::atex
+
+#endif
@@ -0,0 +1,442 @@
+#include "dds_writer.hpp"
+#include <be/core/byte_order.hpp>
+#include <be/core/glm.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace be::atex {
+namespace {
+
+using namespace gfx::tex;
+
+constexpr U32 dds_magic = 0x20534444; // "DDS "
+constexpr U32 fourcc_dx10 = 0x30315844; // "DX10"
+constexpr U32 fourcc_dxt1 = 0x31545844; // "DXT1"
+constexpr U32 fourcc_dxt3 = 0x33545844; // "DXT3"
+constexpr U32 fourcc_dxt5 = 0x35545844; // "DXT5"
+constexpr U32 fourcc_ati1 = 0x31495441; // "ATI1"
+constexpr U32 fourcc_ati2 = 0x32495441; // "ATI2"
+
+constexpr U32 ddsd_caps = 0x1;
+constexpr U32 ddsd_height = 0x2;
+constexpr U32 ddsd_width = 0x4;
+constexpr U32 ddsd_pitch = 0x8;
+constexpr U32 ddsd_pixelformat = 0x1000;
+constexpr U32 ddsd_mipmapcount = 0x20000;
+constexpr U32 ddsd_linearsize = 0x80000;
+constexpr U32 ddsd_depth = 0x800000;
+
+constexpr U32 ddpf_alphapixels = 0x1;
+constexpr U32 ddpf_fourcc = 0x4;
+constexpr U32 ddpf_rgb = 0x40;
+
+constexpr U32 ddscaps_complex = 0x8;
+constexpr U32 ddscaps_texture = 0x1000;
+constexpr U32 ddscaps_mipmap = 0x400000;
+
+constexpr U32 ddscaps2_cubemap_all_faces = 0xFE00;
+constexpr U32 ddscaps2_volume = 0x200000;
+
+constexpr U32 d3d10_resource_dimension_texture1d = 2;
+constexpr U32 d3d10_resource_dimension_texture2d = 3;
+constexpr U32 d3d10_resource_dimension_texture3d = 4;
+constexpr U32 d3d10_resource_misc_texturecube = 0x4;
+
+constexpr U32 dds_alpha_mode_straight = 1;
+constexpr U32 dds_alpha_mode_premultiplied = 2;
+constexpr U32 dds_alpha_mode_opaque = 3;
+
+constexpr std::size_t header_size = 4 + 124;
+constexpr std::size_t dx10_header_size = 20;
+
+///////////////////////////////////////////////////////////////////////////////
+struct LegacyPixelFormat {
+   U32 flags = 0;
+   U32 fourcc = 0;
+   U32 bit_count = 0;
+   U32 masks[4] = { };
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns false if the format needs a DX10 header.
+bool legacy_pixel_format(const ImageFormat& format, LegacyPixelFormat& pf) {
+   if (format.colorspace() == Colorspace::srgb || format.premultiplied()) {
+      return false;
+   }
+
+   switch (dxgi_format(format)) {
+      case 71: pf.flags = ddpf_fourcc; pf.fourcc = fourcc_dxt1; return true;
+      case 74: pf.flags = ddpf_fourcc; pf.fourcc = fourcc_dxt3; return true;
+      case 77: pf.flags = ddpf_fourcc; pf.fourcc = fourcc_dxt5; return true;
+      case 80: pf.flags = ddpf_fourcc; pf.fourcc = fourcc_ati1; return true;
+      case 83: pf.flags = ddpf_fourcc; pf.fourcc = fourcc_ati2; return true;
+      case 28:
+         pf.flags = ddpf_rgb | (format.components() > 3 ? ddpf_alphapixels : 0);
+         pf.bit_count = 32;
+         pf.masks[0] = 0x000000FF;
+         pf.masks[1] = 0x0000FF00;
+         pf.masks[2] = 0x00FF0000;
+         pf.masks[3] = format.components() > 3 ? 0xFF000000 : 0;
+         return true;
+      case 87:
+         pf.flags = ddpf_rgb | (format.components() > 3 ? ddpf_alphapixels : 0);
+         pf.bit_count = 32;
+         pf.masks[0] = 0x00FF0000;
+         pf.masks[1] = 0x0000FF00;
+         pf.masks[2] = 0x000000FF;
+         pf.masks[3] = format.components() > 3 ? 0xFF000000 : 0;
+         return true;
+      default:
+         return false;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void put_u32(UC* out, U32 value) {
+   out[0] = UC(value);
+   out[1] = UC(value >> 8);
+   out[2] = UC(value >> 16);
+   out[3] = UC(value >> 24);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ivec3 block_counts(const ConstImageView& img) {
+   ImageFormat::block_dim_type block_dim = img.format().block_dim();
+   ivec3 dim = img.dim();
+   return ivec3((dim.x + block_dim.x - 1) / block_dim.x,
+                (dim.y + block_dim.y - 1) / block_dim.y,
+                (dim.z + block_dim.z - 1) / block_dim.z);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DDS images are tightly packed; when the storage is too, the whole image is
+// written with a single call.  Otherwise lines are written one at a time,
+// dropping any padding between blocks.
+void write_image(std::ostream& os, const ConstImageView& img, std::vector<UC>& line_buffer) {
+   ivec3 blocks = block_counts(img);
+   std::size_t block_size = img.format().block_size();
+   std::size_t line_size = blocks.x * block_size;
+   const char* data = static_cast<const char*>(img.data());
+
+   if (img.block_span() == block_size && img.line_span() == line_size && img.plane_span() == line_size * blocks.y) {
+      os.write(data, line_size * blocks.y * blocks.z);
+      return;
+   }
+
+   line_buffer.resize(line_size);
+   for (I32 z = 0; z < blocks.z; ++z) {
+      for (I32 y = 0; y < blocks.y; ++y) {
+         const char* line = data + z * img.plane_span() + y * img.line_span();
+         if (img.block_span() == block_size) {
+            os.write(line, line_size);
+         } else {
+            for (I32 x = 0; x < blocks.x; ++x) {
+               std::memcpy(line_buffer.data() + x * block_size, line + x * img.block_span(), block_size);
+            }
+            os.write(reinterpret_cast<const char*>(line_buffer.data()), line_size);
+         }
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The number of fields stored in each block of the DXGI formats that
+// correspond to a packing, or 0 if there are none.
+glm::length_t dxgi_fields(BlockPacking packing) {
+   switch (packing) {
+      case BlockPacking::c_rgtc1:
+      case BlockPacking::s_8:
+      case BlockPacking::s_16:
+      case BlockPacking::s_32:
+         return 1;
+      case BlockPacking::c_rgtc2:
+      case BlockPacking::s_8_8:
+      case BlockPacking::s_16_16:
+      case BlockPacking::s_32_32:
+         return 2;
+      case BlockPacking::s_32_32_32:
+         return 3;
+      case BlockPacking::c_s3tc1:
+      case BlockPacking::c_s3tc2:
+      case BlockPacking::c_s3tc3:
+      case BlockPacking::c_bptc:
+      case BlockPacking::s_8_8_8_8:
+      case BlockPacking::s_16_16_16_16:
+      case BlockPacking::s_32_32_32_32:
+         return 4;
+      default:
+         return 0;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DXGI formats can't swizzle, so each component must read the field the
+// format stores for it, and no component can be synthesized from another
+// field or a constant.
+bool has_swizzles(const ImageFormat& format, const ImageFormat::swizzles_type& swizzles, glm::length_t fields) {
+   if (format.components() > fields) {
+      return false;
+   }
+   for (glm::length_t c = 0; c < format.components(); ++c) {
+      if (format.swizzle(c) != swizzles[c]) {
+         return false;
+      }
+   }
+   return true;
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+U32 dxgi_format(const ImageFormat& format) {
+   bool srgb = format.colorspace() == Colorspace::srgb;
+   FieldType type = format.field_type(0);
+
+   ImageFormat::swizzles_type rgba = swizzles_rgba();
+   if (format.packing() == BlockPacking::s_8_8_8_8) {
+      ImageFormat::swizzles_type bgra = rgba;
+      std::swap(bgra.r, bgra.b);
+      if (has_swizzles(format, bgra, 4)) {
+         return type == FieldType::unorm ? (srgb ? 91 : 87) : 0;
+      }
+   }
+
+   if (!has_swizzles(format, rgba, dxgi_fields(format.packing()))) {
+      return 0;
+   }
+
+   switch (format.packing()) {
+      case BlockPacking::c_s3tc1: return type == FieldType::unorm ? (srgb ? 72 : 71) : 0;
+      case BlockPacking::c_s3tc2: return type == FieldType::unorm ? (srgb ? 75 : 74) : 0;
+      case BlockPacking::c_s3tc3: return type == FieldType::unorm ? (srgb ? 78 : 77) : 0;
+      case BlockPacking::c_rgtc1: return type == FieldType::snorm ? 81 : type == FieldType::unorm ? 80 : 0;
+      case BlockPacking::c_rgtc2: return type == FieldType::snorm ? 84 : type == FieldType::unorm ? 83 : 0;
+      case BlockPacking::c_bptc:
+         switch (type) {
+            case FieldType::unorm:  return srgb ? 99 : 98;
+            case FieldType::ufloat: return 95;
+            case FieldType::sfloat: return 96;
+            default:                return 0;
+         }
+
+      case BlockPacking::s_8_8_8_8:
+         switch (type) {
+            case FieldType::unorm: return srgb ? 29 : 28;
+            case FieldType::uint:  return 30;
+            case FieldType::snorm: return 31;
+            case FieldType::sint:  return 32;
+            default:               return 0;
+         }
+      case BlockPacking::s_8_8:
+         switch (type) {
+            case FieldType::unorm: return 49;
+            case FieldType::uint:  return 50;
+            case FieldType::snorm: return 51;
+            case FieldType::sint:  return 52;
+            default:               return 0;
+         }
+      case BlockPacking::s_8:
+         switch (type) {
+            case FieldType::unorm: return 61;
+            case FieldType::uint:  return 62;
+            case FieldType::snorm: return 63;
+            case FieldType::sint:  return 64;
+            default:               return 0;
+         }
+
+      case BlockPacking::s_16_16_16_16:
+         switch (type) {
+            case FieldType::sfloat: return 10;
+            case FieldType::unorm:  return 11;
+            case FieldType::uint:   return 12;
+            case FieldType::snorm:  return 13;
+            case FieldType::sint:   return 14;
+            default:                return 0;
+         }
+      case BlockPacking::s_16_16:
+         switch (type) {
+            case FieldType::sfloat: return 34;
+            case FieldType::unorm:  return 35;
+            case FieldType::uint:   return 36;
+            case FieldType::snorm:  return 37;
+            case FieldType::sint:   return 38;
+            default:                return 0;
+         }
+      case BlockPacking::s_16:
+         switch (type) {
+            case FieldType::sfloat: return 54;
+            case FieldType::unorm:  return 56;
+            case FieldType::uint:   return 57;
+            case FieldType::snorm:  return 58;
+            case FieldType::sint:   return 59;
+            default:                return 0;
+         }
+
+      case BlockPacking::s_32_32_32_32:
+         switch (type) {
+            case FieldType::sfloat: return 2;
+            case FieldType::uint:   return 3;
+            case FieldType::sint:   return 4;
+            default:                return 0;
+         }
+      case BlockPacking::s_32_32_32:
+         switch (type) {
+            case FieldType::sfloat: return 6;
+            case FieldType::uint:   return 7;
+            case FieldType::sint:   return 8;
+            default:                return 0;
+         }
+      case BlockPacking::s_32_32:
+         switch (type) {
+            case FieldType::sfloat: return 16;
+            case FieldType::uint:   return 17;
+            case FieldType::sint:   return 18;
+            default:                return 0;
+         }
+      case BlockPacking::s_32:
+         switch (type) {
+            case FieldType::sfloat: return 41;
+            case FieldType::uint:   return 42;
+            case FieldType::sint:   return 43;
+            default:                return 0;
+         }
+
+      default:
+         return 0;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void DdsWriter::texture(const TextureView& view) {
+   view_ = view;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void DdsWriter::write(const Path& path, std::error_code& ec) {
+   std::ofstream ofs(path.c_str(), std::ios::binary | std::ios::trunc);
+   if (!ofs) {
+      ec = std::make_error_code(std::errc::io_error);
+      return;
+   }
+
+   write(ofs, ec);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void DdsWriter::write(std::ostream& os, std::error_code& ec) {
+   // Image data is written straight from storage, so it must already be
+   // little-endian.
+   if (bo::Host::value != bo::Little::value) {
+      ec = std::make_error_code(std::errc::not_supported);
+      return;
+   }
+
+   ImageFormat format = view_.format();
+   U32 dxgi = dxgi_format(format);
+   if (!view_ || dxgi == 0) {
+      ec = std::make_error_code(std::errc::not_supported);
+      return;
+   }
+
+   TextureClass tex_class = view_.texture_class();
+   bool cube = faces(tex_class) == 6 && view_.faces() == 6;
+   if (view_.faces() != (cube ? 6u : 1u)) {
+      ec = std::make_error_code(std::errc::not_supported);
+      return;
+   }
+
+   bool volume = dimensionality(tex_class) == 3;
+   ConstImageView base = view_.image();
+   ivec3 dim = base.dim();
+   ivec3 blocks = block_counts(base);
+   bool compressed = is_compressed(format.packing());
+
+   LegacyPixelFormat pf;
+   bool dx10 = is_array(tex_class) || cube || !legacy_pixel_format(format, pf);
+   if (dx10) {
+      pf = LegacyPixelFormat();
+      pf.flags = ddpf_fourcc;
+      pf.fourcc = fourcc_dx10;
+   }
+
+   U32 flags = ddsd_caps | ddsd_height | ddsd_width | ddsd_pixelformat;
+   U32 pitch_or_linear_size;
+   if (compressed) {
+      flags |= ddsd_linearsize;
+      pitch_or_linear_size = U32(blocks.x * blocks.y * format.block_size());
+   } else {
+      flags |= ddsd_pitch;
+      pitch_or_linear_size = U32(blocks.x * format.block_size());
+   }
+   if (view_.levels() > 1) {
+      flags |= ddsd_mipmapcount;
+   }
+   if (volume) {
+      flags |= ddsd_depth;
+   }
+
+   U32 caps = ddscaps_texture;
+   if (view_.levels() > 1) {
+      caps |= ddscaps_complex | ddscaps_mipmap;
+   }
+   if (cube || volume || view_.layers() > 1) {
+      caps |= ddscaps_complex;
+   }
+
+   U32 caps2 = cube ? ddscaps2_cubemap_all_faces : volume ? ddscaps2_volume : 0;
+
+   UC header[header_size + dx10_header_size] = { };
+   put_u32(header, dds_magic);
+   put_u32(header + 4, 124);
+   put_u32(header + 8, flags);
+   put_u32(header + 12, U32(dim.y));
+   put_u32(header + 16, U32(dim.x));
+   put_u32(header + 20, pitch_or_linear_size);
+   put_u32(header + 24, volume ? U32(dim.z) : 0);
+   put_u32(header + 28, U32(view_.levels()));
+   // 11 reserved DWORDs
+   put_u32(header + 76, 32);
+   put_u32(header + 80, pf.flags);
+   put_u32(header + 84, pf.fourcc);
+   put_u32(header + 88, pf.bit_count);
+   put_u32(header + 92, pf.masks[0]);
+   put_u32(header + 96, pf.masks[1]);
+   put_u32(header + 100, pf.masks[2]);
+   put_u32(header + 104, pf.masks[3]);
+   put_u32(header + 108, caps);
+   put_u32(header + 112, caps2);
+
+   std::size_t size = header_size;
+   if (dx10) {
+      U32 dimension = volume ? d3d10_resource_dimension_texture3d :
+         dimensionality(tex_class) == 1 ? d3d10_resource_dimension_texture1d : d3d10_resource_dimension_texture2d;
+      U32 alpha_mode = format.premultiplied() ? dds_alpha_mode_premultiplied :
+         format.components() > 3 ? dds_alpha_mode_straight : dds_alpha_mode_opaque;
+
+      put_u32(header + header_size, dxgi);
+      put_u32(header + header_size + 4, dimension);
+      put_u32(header + header_size + 8, cube ? d3d10_resource_misc_texturecube : 0);
+      put_u32(header + header_size + 12, U32(view_.layers()));
+      put_u32(header + header_size + 16, alpha_mode);
+      size += dx10_header_size;
+   }
+
+   os.write(reinterpret_cast<const char*>(header), size);
+
+   std::vector<UC> line_buffer;
+   for (std::size_t layer = 0; layer < view_.layers(); ++layer) {
+      for (std::size_t face = 0; face < view_.faces(); ++face) {
+         for (std::size_t level = 0; level < view_.levels(); ++level) {
+            write_image(os, view_.image(layer, face, level), line_buffer);
+         }
+      }
+   }
+
+   if (!os) {
+      ec = std::make_error_code(std::errc::io_error);
+   }
+}
+
+} // be::atex
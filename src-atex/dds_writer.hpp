@@ -0,0 +1,34 @@
+#pragma once
+#ifndef BE_ATEX_DDS_WRITER_HPP_
+#define BE_ATEX_DDS_WRITER_HPP_
+
+#include <be/core/filesystem.hpp>
+#include <be/gfx/tex/texture.hpp>
+#include <iosfwd>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+// Returns the DXGI_FORMAT corresponding to an image format, or 0
+// (DXGI_FORMAT_UNKNOWN) if DDS files can't represent it.
+U32 dxgi_format(const gfx::tex::ImageFormat& format);
+
+///////////////////////////////////////////////////////////////////////////////
+// Writes DirectDraw Surface files.  A legacy header is used for simple 2D
+// textures in formats that older readers understand; arrays, cubemaps, sRGB,
+// premultiplied, and BC6H/BC7 textures get a DX10 extension header.  Image
+// data is streamed directly from the texture's storage.
+class DdsWriter final {
+public:
+   void texture(const gfx::tex::TextureView& view);
+
+   void write(const Path& path, std::error_code& ec);
+   void write(std::ostream& os, std::error_code& ec);
+
+private:
+   gfx::tex::TextureView view_;
+};
+
+} // be::atex
+
+#endif
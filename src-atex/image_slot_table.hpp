@@ -0,0 +1,122 @@
+#pragma once
+#ifndef BE_ATEX_IMAGE_SLOT_TABLE_HPP_
+#define BE_ATEX_IMAGE_SLOT_TABLE_HPP_
+
+#include <be/core/be.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+// Dense table with one slot for each (layer, face, level) triple in a range,
+// stored in a single contiguous allocation.  Slots which haven't been
+// assigned hold the empty value provided at construction.  When include()
+// needs to grow the range, the layer range is over-allocated so that
+// appending layers one or a few at a time doesn't relocate on every call.
+template <typename T>
+class ImageSlotTable final {
+public:
+   explicit ImageSlotTable(T empty = T())
+      : empty_(std::move(empty)) { }
+
+   // Resizes the table to exactly cover the specified (inclusive) ranges.
+   // All slots will be empty afterwards.
+   void reset(std::size_t first_layer, std::size_t last_layer,
+              std::size_t first_face, std::size_t last_face,
+              std::size_t first_level, std::size_t last_level) {
+      base_layer_ = first_layer;
+      base_face_ = first_face;
+      base_level_ = first_level;
+      layers_ = last_layer + 1 - first_layer;
+      faces_ = last_face + 1 - first_face;
+      levels_ = last_level + 1 - first_level;
+      slots_.assign(layers_ * faces_ * levels_, empty_);
+   }
+
+   // Grows the table if necessary so that it covers at least the specified
+   // (inclusive) ranges.  Existing slots keep their values.
+   void include(std::size_t first_layer, std::size_t last_layer,
+                std::size_t first_face, std::size_t last_face,
+                std::size_t first_level, std::size_t last_level) {
+      if (slots_.empty()) {
+         reset(first_layer, last_layer, first_face, last_face, first_level, last_level);
+         return;
+      }
+
+      if (first_layer >= base_layer_ && last_layer < base_layer_ + layers_ &&
+          first_face >= base_face_ && last_face < base_face_ + faces_ &&
+          first_level >= base_level_ && last_level < base_level_ + levels_) {
+         return;
+      }
+
+      std::size_t new_first_layer = std::min(first_layer, base_layer_);
+      std::size_t new_last_layer = std::max(last_layer, base_layer_ + layers_ - 1);
+      if (new_first_layer < base_layer_) {
+         new_first_layer -= std::min(new_first_layer, layers_);
+      }
+      if (new_last_layer >= base_layer_ + layers_) {
+         new_last_layer += layers_;
+      }
+
+      ImageSlotTable<T> grown(empty_);
+      grown.reset(new_first_layer, new_last_layer,
+                  std::min(first_face, base_face_), std::max(last_face, base_face_ + faces_ - 1),
+                  std::min(first_level, base_level_), std::max(last_level, base_level_ + levels_ - 1));
+
+      for (std::size_t layer = 0; layer < layers_; ++layer) {
+         for (std::size_t face = 0; face < faces_; ++face) {
+            auto begin = slots_.begin() + index_(base_layer_ + layer, base_face_ + face, base_level_);
+            std::move(begin, begin + levels_, grown.slots_.begin() + grown.index_(base_layer_ + layer, base_face_ + face, base_level_));
+         }
+      }
+
+      *this = std::move(grown);
+   }
+
+   bool contains(std::size_t layer, std::size_t face, std::size_t level) const {
+      return layer >= base_layer_ && layer - base_layer_ < layers_ &&
+             face >= base_face_ && face - base_face_ < faces_ &&
+             level >= base_level_ && level - base_level_ < levels_;
+   }
+
+   // Returns nullptr if the triple is outside the table's range.
+   T* find(std::size_t layer, std::size_t face, std::size_t level) {
+      return contains(layer, face, level) ? &slots_[index_(layer, face, level)] : nullptr;
+   }
+
+   const T* find(std::size_t layer, std::size_t face, std::size_t level) const {
+      return contains(layer, face, level) ? &slots_[index_(layer, face, level)] : nullptr;
+   }
+
+   // The triple must be inside the table's range.
+   T& operator()(std::size_t layer, std::size_t face, std::size_t level) {
+      return slots_[index_(layer, face, level)];
+   }
+
+   const T& operator()(std::size_t layer, std::size_t face, std::size_t level) const {
+      return slots_[index_(layer, face, level)];
+   }
+
+   const T& empty_value() const {
+      return empty_;
+   }
+
+private:
+   std::size_t index_(std::size_t layer, std::size_t face, std::size_t level) const {
+      return ((layer - base_layer_) * faces_ + (face - base_face_)) * levels_ + (level - base_level_);
+   }
+
+   T empty_;
+   std::size_t base_layer_ = 0;
+   std::size_t base_face_ = 0;
+   std::size_t base_level_ = 0;
+   std::size_t layers_ = 0;
+   std::size_t faces_ = 0;
+   std::size_t levels_ = 0;
+   std::vector<T> slots_;
+};
+
+} // be::atex
+
+#endif
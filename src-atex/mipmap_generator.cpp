@@ -0,0 +1,430 @@
+#include "mipmap_generator.hpp"
+#include "blit_kernels.hpp"
+#include "working_image.hpp"
+#include <be/gfx/tex/blit_pixels.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP) && _M_IX86_FP >= 2
+#define BE_ATEX_MIPMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace be::atex {
+namespace {
+
+using namespace gfx::tex;
+
+// Kaiser and Lanczos filter support, in destination texels.
+constexpr F64 filter_radius = 3.0;
+constexpr F64 kaiser_alpha = 4.0;
+
+constexpr std::size_t working_texel_size = 4 * sizeof(F32);
+
+///////////////////////////////////////////////////////////////////////////////
+ImageFormat make_working_format(const ImageFormat& format) {
+   bool color = format.components() == 4 &&
+      (format.colorspace() == Colorspace::srgb || format.colorspace() == Colorspace::linear_srgb);
+
+   ImageFormat result = format;
+   result.packing(BlockPacking::s_32_32_32_32);
+   result.block_dim(ImageFormat::block_dim_type(1));
+   result.block_size(ImageFormat::block_size_type(working_texel_size));
+   result.components(4);
+   result.field_types(ImageFormat::field_types_type(FieldType::sfloat));
+   result.swizzles(swizzles_rgba());
+   if (format.colorspace() == Colorspace::srgb) {
+      result.colorspace(Colorspace::linear_srgb);
+   }
+   result.premultiplied(color || format.premultiplied());
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void copy_image(const ConstImageView& src, const ImageView& dest) {
+   ImageRegion region = pixel_region(src);
+   if (!blit_pixels_fast(src, dest, region)) {
+      blit_pixels(src, region, dest, region);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WorkingImage load_image(const ConstImageView& src, const ImageFormat& working_format) {
+   WorkingImage result(src.dim(), working_format);
+   copy_image(src, result.image());
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+F64 sinc(F64 x) {
+   if (std::abs(x) < 1e-9) {
+      return 1.0;
+   }
+   x *= glm::pi<F64>();
+   return std::sin(x) / x;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Modified Bessel function of the first kind, order 0
+F64 bessel_i0(F64 x) {
+   F64 sum = 1.0;
+   F64 term = 1.0;
+   F64 q = x * x * 0.25;
+   for (int k = 1; k < 64; ++k) {
+      term *= q / F64(k * k);
+      sum += term;
+      if (term < sum * 1e-12) {
+         break;
+      }
+   }
+   return sum;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+F64 filter_weight(MipmapFilter filter, F64 x) {
+   x = std::abs(x);
+   if (x >= filter_radius) {
+      return 0.0;
+   }
+
+   switch (filter) {
+      case MipmapFilter::kaiser: {
+         F64 t = x / filter_radius;
+         return sinc(x) * bessel_i0(kaiser_alpha * std::sqrt(1.0 - t * t)) / bessel_i0(kaiser_alpha);
+      }
+      case MipmapFilter::lanczos:
+         return sinc(x) * sinc(x / filter_radius);
+      default:
+         return x < 0.5 ? 1.0 : 0.0;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Filter weights for resampling one axis.  Every destination texel uses the
+// same number of taps, starting at first[n], so that the inner loops have a
+// fixed trip count; unused taps have a weight of zero.  Source texels past
+// the edge of the image are clamped to the edge.
+struct FilterTaps {
+   std::size_t taps = 0;
+   std::vector<I32> first;
+   std::vector<F32> weights;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+FilterTaps make_filter_taps(I32 src_size, I32 dest_size, MipmapFilter filter) {
+   F64 scale = F64(src_size) / F64(dest_size);
+   F64 radius = (filter == MipmapFilter::box ? 0.5 : filter_radius) * scale;
+
+   std::vector<I32> firsts(dest_size);
+   std::vector<std::vector<F64>> windows(dest_size);
+   std::size_t max_taps = 1;
+
+   for (I32 n = 0; n < dest_size; ++n) {
+      F64 center = (n + 0.5) * scale;
+      I32 lo = I32(std::floor(center - radius));
+      I32 hi = I32(std::ceil(center + radius));
+      I32 first = std::max(lo, 0);
+      I32 last = std::min(hi, src_size) - 1;
+
+      std::vector<F64>& window = windows[n];
+      window.assign(std::size_t(last - first + 1), 0.0);
+
+      F64 total = 0.0;
+      for (I32 i = lo; i < hi; ++i) {
+         F64 weight;
+         if (filter == MipmapFilter::box) {
+            // exact area coverage, so non-power-of-two sizes are handled too
+            weight = std::max(0.0, std::min(i + 1.0, center + radius) - std::max(F64(i), center - radius));
+         } else {
+            weight = filter_weight(filter, (i + 0.5 - center) / scale);
+         }
+         window[std::clamp(i, first, last) - first] += weight;
+         total += weight;
+      }
+
+      for (F64& weight : window) {
+         weight /= total;
+      }
+
+      firsts[n] = first;
+      max_taps = std::max(max_taps, window.size());
+   }
+
+   FilterTaps result;
+   result.taps = max_taps;
+   result.first.resize(dest_size);
+   result.weights.assign(dest_size * max_taps, 0.f);
+   for (I32 n = 0; n < dest_size; ++n) {
+      I32 first = std::min(firsts[n], src_size - I32(max_taps));
+      std::size_t offset = std::size_t(firsts[n] - first);
+      result.first[n] = first;
+      for (std::size_t t = 0; t < windows[n].size(); ++t) {
+         result.weights[n * max_taps + offset + t] = F32(windows[n][t]);
+      }
+   }
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// dest[i] = sum(weights[t] * src[t][i])
+void filter_lines(const F32* const* src, const F32* weights, std::size_t taps, F32* dest, std::size_t count) {
+   const F32* s = src[0];
+   F32 w = weights[0];
+   for (std::size_t i = 0; i < count; ++i) {
+      dest[i] = w * s[i];
+   }
+   for (std::size_t t = 1; t < taps; ++t) {
+      s = src[t];
+      w = weights[t];
+      if (w == 0.f) {
+         continue;
+      }
+      for (std::size_t i = 0; i < count; ++i) {
+         dest[i] += w * s[i];
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void filter_texels(const F32* src, F32* dest, const FilterTaps& taps) {
+   const F32* weights = taps.weights.data();
+   for (std::size_t n = 0; n < taps.first.size(); ++n, weights += taps.taps, dest += 4) {
+      const F32* s = src + taps.first[n] * 4;
+#ifdef BE_ATEX_MIPMAP_SSE2
+      __m128 acc = _mm_setzero_ps();
+      for (std::size_t t = 0; t < taps.taps; ++t) {
+         acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(s + t * 4)));
+      }
+      _mm_storeu_ps(dest, acc);
+#else
+      F32 acc[4] = { };
+      for (std::size_t t = 0; t < taps.taps; ++t) {
+         for (std::size_t c = 0; c < 4; ++c) {
+            acc[c] += weights[t] * s[t * 4 + c];
+         }
+      }
+      std::copy(acc, acc + 4, dest);
+#endif
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WorkingImage filter_planes(const WorkingImage& src, I32 planes, MipmapFilter filter) {
+   ivec3 dim = src.dim();
+   FilterTaps taps = make_filter_taps(dim.z, planes, filter);
+   dim.z = planes;
+   WorkingImage result(dim, src.format());
+   std::vector<const F32*> lines(taps.taps);
+   for (I32 z = 0; z < dim.z; ++z) {
+      for (I32 y = 0; y < dim.y; ++y) {
+         for (std::size_t t = 0; t < taps.taps; ++t) {
+            lines[t] = src.line<F32>(y, taps.first[z] + I32(t));
+         }
+         filter_lines(lines.data(), taps.weights.data() + z * taps.taps, taps.taps, result.line<F32>(y, z), dim.x * 4u);
+      }
+   }
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WorkingImage filter_rows(const WorkingImage& src, I32 rows, MipmapFilter filter) {
+   ivec3 dim = src.dim();
+   FilterTaps taps = make_filter_taps(dim.y, rows, filter);
+   dim.y = rows;
+   WorkingImage result(dim, src.format());
+   std::vector<const F32*> lines(taps.taps);
+   for (I32 z = 0; z < dim.z; ++z) {
+      for (I32 y = 0; y < dim.y; ++y) {
+         for (std::size_t t = 0; t < taps.taps; ++t) {
+            lines[t] = src.line<F32>(taps.first[y] + I32(t), z);
+         }
+         filter_lines(lines.data(), taps.weights.data() + y * taps.taps, taps.taps, result.line<F32>(y, z), dim.x * 4u);
+      }
+   }
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WorkingImage filter_columns(const WorkingImage& src, I32 columns, MipmapFilter filter) {
+   ivec3 dim = src.dim();
+   FilterTaps taps = make_filter_taps(dim.x, columns, filter);
+   dim.x = columns;
+   WorkingImage result(dim, src.format());
+   for (I32 z = 0; z < dim.z; ++z) {
+      for (I32 y = 0; y < dim.y; ++y) {
+         filter_texels(src.line<F32>(y, z), result.line<F32>(y, z), taps);
+      }
+   }
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Each axis is filtered separately; the axes which shrink the most data are
+// done first.
+WorkingImage downsample(const WorkingImage& src, ivec3 dim, MipmapFilter filter) {
+   if (src.dim() == dim) {
+      return src.clone();
+   }
+
+   WorkingImage result;
+   const WorkingImage* image = &src;
+   if (image->dim().z != dim.z) {
+      result = filter_planes(*image, dim.z, filter);
+      image = &result;
+   }
+   if (image->dim().y != dim.y) {
+      result = filter_rows(*image, dim.y, filter);
+      image = &result;
+   }
+   if (image->dim().x != dim.x) {
+      result = filter_columns(*image, dim.x, filter);
+   }
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Kaiser and Lanczos filters have negative lobes, which can ring below zero or
+// above full opacity near sharp edges.
+void clamp_colors(WorkingImage& image) {
+   ivec3 dim = image.dim();
+   for (I32 z = 0; z < dim.z; ++z) {
+      for (I32 y = 0; y < dim.y; ++y) {
+         F32* texel = image.line<F32>(y, z);
+         for (I32 x = 0; x < dim.x; ++x, texel += 4) {
+            texel[3] = std::clamp(texel[3], 0.f, 1.f);
+            for (std::size_t c = 0; c < 3; ++c) {
+               texel[c] = std::max(texel[c], 0.f);
+            }
+         }
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+F32 alpha_coverage(const WorkingImage& image, F32 reference, F32 scale) {
+   ivec3 dim = image.dim();
+   std::size_t covered = 0;
+   for (I32 z = 0; z < dim.z; ++z) {
+      for (I32 y = 0; y < dim.y; ++y) {
+         const F32* texel = image.line<F32>(y, z);
+         for (I32 x = 0; x < dim.x; ++x, texel += 4) {
+            if (texel[3] * scale > reference) {
+               ++covered;
+            }
+         }
+      }
+   }
+   return F32(F64(covered) / (F64(dim.x) * dim.y * dim.z));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Scales alpha so that the fraction of texels passing an alpha test against
+// the reference value matches the coverage of the source level.  This keeps
+// alpha-tested foliage, fences, etc. from thinning out in distant mips.
+void preserve_alpha_coverage(WorkingImage& image, F32 reference, F32 coverage) {
+   F32 lo = 0.f;
+   F32 hi = 8.f;
+   for (int i = 0; i < 16; ++i) {
+      F32 mid = (lo + hi) * 0.5f;
+      if (alpha_coverage(image, reference, mid) < coverage) {
+         lo = mid;
+      } else {
+         hi = mid;
+      }
+   }
+   F32 scale = (lo + hi) * 0.5f;
+
+   bool premultiplied = image.format().premultiplied();
+   ivec3 dim = image.dim();
+   for (I32 z = 0; z < dim.z; ++z) {
+      for (I32 y = 0; y < dim.y; ++y) {
+         F32* texel = image.line<F32>(y, z);
+         for (I32 x = 0; x < dim.x; ++x, texel += 4) {
+            F32 alpha = std::min(texel[3] * scale, 1.f);
+            if (premultiplied) {
+               // keep the unpremultiplied color the same
+               F32 color_scale = texel[3] > 0.f ? alpha / texel[3] : 0.f;
+               for (std::size_t c = 0; c < 3; ++c) {
+                  texel[c] *= color_scale;
+               }
+            }
+            texel[3] = alpha;
+         }
+      }
+   }
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+const char* mipmap_filter_name(MipmapFilter filter) {
+   switch (filter) {
+      case MipmapFilter::box:     return "box";
+      case MipmapFilter::kaiser:  return "kaiser";
+      case MipmapFilter::lanczos: return "lanczos";
+      default:                    return "?";
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool parse_mipmap_filter(const S& name, MipmapFilter& filter) {
+   for (MipmapFilter f : { MipmapFilter::box, MipmapFilter::kaiser, MipmapFilter::lanczos }) {
+      if (name == mipmap_filter_name(f)) {
+         filter = f;
+         return true;
+      }
+   }
+   return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void generate_mipmaps(const TextureView& view, std::size_t layer, std::size_t face,
+                      const std::vector<U8>& provided_levels, const MipmapOptions& options) {
+   auto is_provided = [&](std::size_t level) {
+      return level < provided_levels.size() && provided_levels[level] != 0;
+   };
+
+   std::size_t levels = view.levels();
+   std::size_t level = 0;
+   while (level < levels && !is_provided(level)) {
+      ++level;
+   }
+   if (level >= levels) {
+      return;
+   }
+
+   ImageFormat working_format = make_working_format(view.format());
+   bool clamp = working_format.premultiplied() && options.filter != MipmapFilter::box;
+   bool preserve_coverage = options.preserve_alpha_coverage && view.format().components() == 4;
+
+   WorkingImage current = load_image(view.image(layer, face, level), working_format);
+   F32 coverage = preserve_coverage ? alpha_coverage(current, options.alpha_reference, 1.f) : 0.f;
+
+   for (++level; level < levels; ++level) {
+      ImageView dest = view.image(layer, face, level);
+      if (is_provided(level)) {
+         current = load_image(dest, working_format);
+         continue;
+      }
+
+      WorkingImage next = downsample(current, dest.dim(), options.filter);
+      if (clamp) {
+         clamp_colors(next);
+      }
+
+      if (preserve_coverage) {
+         // further levels are filtered from the unscaled image so that the
+         // adjustments don't compound
+         WorkingImage scaled = next.clone();
+         preserve_alpha_coverage(scaled, options.alpha_reference, coverage);
+         copy_image(scaled.image(), dest);
+      } else {
+         copy_image(next.image(), dest);
+      }
+
+      current = std::move(next);
+   }
+}
+
+} // be::atex
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef BE_ATEX_MIPMAP_GENERATOR_HPP_
+#define BE_ATEX_MIPMAP_GENERATOR_HPP_
+
+#include <be/gfx/tex/texture.hpp>
+#include <vector>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+enum class MipmapFilter : U8 {
+   box,
+   kaiser,
+   lanczos
+};
+
+const char* mipmap_filter_name(MipmapFilter filter);
+bool parse_mipmap_filter(const S& name, MipmapFilter& filter);
+
+///////////////////////////////////////////////////////////////////////////////
+struct MipmapOptions {
+   MipmapFilter filter = MipmapFilter::box;
+   bool preserve_alpha_coverage = false;
+   F32 alpha_reference = 0.5f;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Fills in the mipmap levels of a single layer/face of a texture.  The first
+// level for which provided_levels is nonzero is the source image; each
+// following level is either kept as-is (if it is also provided) or filtered
+// from the level above it.  Filtering is done on linear RGBA32F data, so sRGB
+// images are filtered with correct gamma, and color images are premultiplied
+// while filtering so that transparent texels don't bleed into their
+// neighbors.  The texture's format must not be compressed.
+void generate_mipmaps(const gfx::tex::TextureView& view, std::size_t layer, std::size_t face,
+                      const std::vector<U8>& provided_levels, const MipmapOptions& options);
+
+} // be::atex
+
+#endif
@@ -0,0 +1,208 @@
+#include "profiler.hpp"
+#include <ostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+namespace be::atex {
+namespace {
+
+#ifdef _WIN32
+///////////////////////////////////////////////////////////////////////////////
+U64 filetime_us(const FILETIME& ft) {
+   return ((U64(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) / 10;
+}
+#else
+///////////////////////////////////////////////////////////////////////////////
+U64 clock_us(clockid_t clock) {
+   timespec ts;
+   if (clock_gettime(clock, &ts) != 0) {
+      return 0;
+   }
+   return U64(ts.tv_sec) * 1000000 + U64(ts.tv_nsec) / 1000;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+void write_json_string(std::ostream& os, const S& str) {
+   static const char hex[] = "0123456789abcdef";
+   os << '"';
+   for (char c : str) {
+      switch (c) {
+         case '"':  os << "\\\""; break;
+         case '\\': os << "\\\\"; break;
+         case '\n': os << "\\n"; break;
+         case '\r': os << "\\r"; break;
+         case '\t': os << "\\t"; break;
+         default:
+            if (U8(c) < 0x20) {
+               os << "\\u00" << hex[U8(c) >> 4] << hex[U8(c) & 0xF];
+            } else {
+               os << c;
+            }
+            break;
+      }
+   }
+   os << '"';
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void write_event_fields(std::ostream& os, const Profiler::Event& event) {
+   os << "\"bytes_read\":" << event.bytes_read
+      << ",\"bytes_written\":" << event.bytes_written
+      << ",\"pixels\":" << event.pixels
+      << ",\"cpu_us\":" << event.cpu_us
+      << ",\"peak_rss\":" << event.peak_rss;
+   if (!event.path.empty()) {
+      os << ",\"path\":";
+      write_json_string(os, event.path);
+   }
+}
+
+} // be::atex::()
+
+///////////////////////////////////////////////////////////////////////////////
+U64 process_cpu_us() {
+#ifdef _WIN32
+   FILETIME creation, exit, kernel, user;
+   if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+      return 0;
+   }
+   return filetime_us(kernel) + filetime_us(user);
+#else
+   return clock_us(CLOCK_PROCESS_CPUTIME_ID);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U64 thread_cpu_us() {
+#ifdef _WIN32
+   FILETIME creation, exit, kernel, user;
+   if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+      return 0;
+   }
+   return filetime_us(kernel) + filetime_us(user);
+#else
+   return clock_us(CLOCK_THREAD_CPUTIME_ID);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U64 peak_rss_bytes() {
+#ifdef _WIN32
+   PROCESS_MEMORY_COUNTERS counters;
+   if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+      return 0;
+   }
+   return U64(counters.PeakWorkingSetSize);
+#else
+   rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) != 0) {
+      return 0;
+   }
+#ifdef __APPLE__
+   return U64(usage.ru_maxrss);
+#else
+   return U64(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Profiler::Scope::Scope(Profiler* profiler, S name, S path)
+   : profiler_(profiler) {
+   if (profiler_) {
+      event_.name = std::move(name);
+      event_.path = std::move(path);
+      start_ = std::chrono::steady_clock::now();
+      start_cpu_us_ = event_.path.empty() ? process_cpu_us() : thread_cpu_us();
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Profiler::Scope::Scope(Scope&& other) noexcept
+   : profiler_(other.profiler_),
+     event_(std::move(other.event_)),
+     start_(other.start_),
+     start_cpu_us_(other.start_cpu_us_) {
+   other.profiler_ = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Profiler::Scope::~Scope() {
+   if (profiler_) {
+      auto now = std::chrono::steady_clock::now();
+      U64 cpu_us = event_.path.empty() ? process_cpu_us() : thread_cpu_us();
+      event_.start_us = U64(std::chrono::duration_cast<std::chrono::microseconds>(start_ - profiler_->epoch_).count());
+      event_.wall_us = U64(std::chrono::duration_cast<std::chrono::microseconds>(now - start_).count());
+      event_.cpu_us = cpu_us - start_cpu_us_;
+      event_.peak_rss = peak_rss_bytes();
+      profiler_->record(std::move(event_));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Profiler::Profiler()
+   : epoch_(std::chrono::steady_clock::now()) {
+   threads_.emplace(std::this_thread::get_id(), 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Profiler::record(Event event) {
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto result = threads_.emplace(std::this_thread::get_id(), U32(threads_.size()));
+   event.thread = result.first->second;
+   events_.push_back(std::move(event));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Profiler::Event> Profiler::events() const {
+   std::lock_guard<std::mutex> lock(mutex_);
+   return events_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Profiler::write_json(std::ostream& os) const {
+   std::vector<Event> events = this->events();
+   os << "{\"events\":[";
+   for (std::size_t i = 0; i < events.size(); ++i) {
+      const Event& event = events[i];
+      os << (i > 0 ? ",\n" : "\n") << "{\"name\":";
+      write_json_string(os, event.name);
+      os << ",\"thread\":" << event.thread
+         << ",\"start_us\":" << event.start_us
+         << ",\"wall_us\":" << event.wall_us << ',';
+      write_event_fields(os, event);
+      os << '}';
+   }
+   os << "\n]}\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Profiler::write_chrome_trace(std::ostream& os) const {
+   std::vector<Event> events = this->events();
+   os << "{\"traceEvents\":[";
+   for (std::size_t i = 0; i < events.size(); ++i) {
+      const Event& event = events[i];
+      os << (i > 0 ? ",\n" : "\n") << "{\"name\":";
+      write_json_string(os, event.name);
+      os << ",\"cat\":\"" << (event.path.empty() ? "phase" : "file") << '"'
+         << ",\"ph\":\"X\",\"pid\":1"
+         << ",\"tid\":" << event.thread
+         << ",\"ts\":" << event.start_us
+         << ",\"dur\":" << event.wall_us
+         << ",\"args\":{";
+      write_event_fields(os, event);
+      os << "}}";
+   }
+   os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+} // be::atex
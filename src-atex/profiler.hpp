@@ -0,0 +1,75 @@
+#pragma once
+#ifndef BE_ATEX_PROFILER_HPP_
+#define BE_ATEX_PROFILER_HPP_
+
+#include <be/core/be.hpp>
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+// Collects timing and throughput events for whole phases of a run and for
+// individual files.  Events may be recorded from any thread.
+class Profiler final {
+public:
+   struct Event {
+      S name;
+      S path; // empty for phases
+      U32 thread = 0;
+      U64 start_us = 0;
+      U64 wall_us = 0;
+      U64 cpu_us = 0; // process CPU time for phases, thread CPU time for files
+      U64 bytes_read = 0;
+      U64 bytes_written = 0;
+      U64 pixels = 0;
+      U64 peak_rss = 0;
+   };
+
+   // Records an event when destroyed.  A scope created with a null profiler
+   // does nothing, so call sites don't need to check whether profiling is on.
+   class Scope final {
+   public:
+      Scope(Profiler* profiler, S name, S path = S());
+      Scope(Scope&& other) noexcept;
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+      ~Scope();
+
+      void bytes_read(U64 bytes) { event_.bytes_read += bytes; }
+      void bytes_written(U64 bytes) { event_.bytes_written += bytes; }
+      void pixels(U64 pixels) { event_.pixels += pixels; }
+
+   private:
+      Profiler* profiler_;
+      Event event_;
+      std::chrono::steady_clock::time_point start_;
+      U64 start_cpu_us_ = 0;
+   };
+
+   Profiler();
+
+   void record(Event event);
+   std::vector<Event> events() const;
+
+   void write_json(std::ostream& os) const;
+   void write_chrome_trace(std::ostream& os) const;
+
+private:
+   std::chrono::steady_clock::time_point epoch_;
+   mutable std::mutex mutex_;
+   std::vector<Event> events_;
+   std::unordered_map<std::thread::id, U32> threads_;
+};
+
+U64 process_cpu_us();
+U64 thread_cpu_us();
+U64 peak_rss_bytes();
+
+} // be::atex
+
+#endif
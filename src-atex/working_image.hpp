@@ -0,0 +1,75 @@
+#pragma once
+#ifndef BE_ATEX_WORKING_IMAGE_HPP_
+#define BE_ATEX_WORKING_IMAGE_HPP_
+
+#include <be/core/glm.hpp>
+#include <be/gfx/tex/texture.hpp>
+#include <cstring>
+
+namespace be::atex {
+
+///////////////////////////////////////////////////////////////////////////////
+// A single uncompressed image with its own storage, used as scratch space
+// when an image needs to be converted to a format that can be processed
+// directly (eg. RGBA32F for filtering or RGBA8 for block encoding).
+class WorkingImage final {
+public:
+   WorkingImage() = default;
+
+   WorkingImage(ivec3 dim, const gfx::tex::ImageFormat& format)
+      : dim_(dim),
+        texel_size_(format.block_size()) {
+      using namespace gfx::tex;
+      texture_.storage = std::make_unique<TextureStorage>(1, 1, 1, dim, format.block_dim(), format.block_size(), TextureAlignment());
+      texture_.view = TextureView(format, dim.z > 1 ? TextureClass::volumetric : TextureClass::planar, *texture_.storage, 0, 1, 0, 1, 0, 1);
+
+      ImageView img = image();
+      data_ = static_cast<UC*>(img.data());
+      line_span_ = img.line_span();
+      plane_span_ = img.plane_span();
+   }
+
+   ivec3 dim() const {
+      return dim_;
+   }
+
+   gfx::tex::ImageFormat format() const {
+      return texture_.view.format();
+   }
+
+   gfx::tex::ImageView image() const {
+      return texture_.view.image();
+   }
+
+   template <typename T>
+   T* line(I32 y, I32 z) {
+      return reinterpret_cast<T*>(data_ + z * plane_span_ + y * line_span_);
+   }
+
+   template <typename T>
+   const T* line(I32 y, I32 z) const {
+      return reinterpret_cast<const T*>(data_ + z * plane_span_ + y * line_span_);
+   }
+
+   WorkingImage clone() const {
+      WorkingImage result(dim_, format());
+      for (I32 z = 0; z < dim_.z; ++z) {
+         for (I32 y = 0; y < dim_.y; ++y) {
+            std::memcpy(result.line<UC>(y, z), line<UC>(y, z), dim_.x * texel_size_);
+         }
+      }
+      return result;
+   }
+
+private:
+   gfx::tex::Texture texture_;
+   ivec3 dim_;
+   std::size_t texel_size_ = 0;
+   UC* data_ = nullptr;
+   std::size_t line_span_ = 0;
+   std::size_t plane_span_ = 0;
+};
+
+} // be::atex
+
+#endif
@@ -0,0 +1,119 @@
+#include "batch.hpp"
+#include "command_line.hpp"
+#include <be/core/filesystem.hpp>
+#include <fstream>
+
+namespace be::tools {
+namespace {
+
+// The held records of the job running on this thread, if any.
+thread_local std::vector<LogRecord>* job_records = nullptr;
+
+} // be::tools::()
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<BatchLine> read_batch_manifest(const S& path) {
+   std::ifstream ifs;
+   std::istream* is = &std::cin;
+   if (path != "-") {
+      ifs.open(path, std::ios::in);
+      if (!ifs) {
+         throw fs::filesystem_error("Failed to open batch manifest", path, std::make_error_code(std::errc::no_such_file_or_directory));
+      }
+      is = &ifs;
+   }
+
+   std::vector<BatchLine> lines;
+   S line;
+   for (std::size_t line_number = 1; std::getline(*is, line); ++line_number) {
+      std::vector<S> args = split_command_line(line);
+      if (args.empty() || args.front()[0] == '#') {
+         continue;
+      }
+
+      BatchLine batch_line;
+      batch_line.line = line_number;
+      batch_line.args = std::move(args);
+      lines.push_back(std::move(batch_line));
+   }
+   return lines;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BatchLog::BatchLog(const std::vector<BatchLine>& lines)
+   : lines_(lines),
+     previous_handler_(default_log().handler()),
+     records_(lines.size()),
+     finished_(lines.size(), false) {
+   default_log().handler([this](const LogRecord& rec) { handle_(rec); });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BatchLog::~BatchLog() {
+   // If a job threw, its successors were never written; nothing is left
+   // running now, so everything still held is written in order.
+   {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      std::fill(finished_.begin(), finished_.end(), true);
+      write_finished_();
+   }
+   default_log().handler(previous_handler_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BatchLog::JobScope::JobScope(BatchLog& log, std::size_t job)
+   : previous_(job_records) {
+   job_records = &log.records_[job];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BatchLog::JobScope::~JobScope() {
+   job_records = previous_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void BatchLog::finish(std::size_t job) {
+   std::lock_guard<std::recursive_mutex> lock(mutex_);
+   finished_[job] = true;
+   write_finished_();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void BatchLog::handle_(const LogRecord& rec) {
+   if (job_records) {
+      // Only the job's own thread touches its records until it finishes
+      job_records->push_back(rec);
+      return;
+   }
+
+   std::lock_guard<std::recursive_mutex> lock(mutex_);
+   if (previous_handler_) {
+      previous_handler_(rec);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The caller must hold mutex_.  The notice is logged normally; since this
+// thread isn't in a JobScope, it goes straight to the previous handler.
+void BatchLog::write_finished_() {
+   for (; next_to_write_ < finished_.size() && finished_[next_to_write_]; ++next_to_write_) {
+      std::vector<LogRecord>& records = records_[next_to_write_];
+      if (records.empty()) {
+         continue;
+      }
+
+      be_notice() << "Batch job log"
+         & attr("Manifest Line") << lines_[next_to_write_].line
+         | default_log();
+
+      if (previous_handler_) {
+         for (const LogRecord& rec : records) {
+            previous_handler_(rec);
+         }
+      }
+      records.clear();
+      records.shrink_to_fit();
+   }
+}
+
+} // be::tools
@@ -0,0 +1,115 @@
+#pragma once
+#ifndef BE_TOOLS_BATCH_HPP_
+#define BE_TOOLS_BATCH_HPP_
+
+#include "job_pool.hpp"
+#include <be/core/logging.hpp>
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace be::tools {
+
+///////////////////////////////////////////////////////////////////////////////
+// One command line from a --batch manifest.
+struct BatchLine {
+   std::size_t line = 0; // 1-based line number in the manifest
+   std::vector<S> args;
+};
+
+// Reads a --batch manifest, or standard input if path is "-".  Blank lines
+// and lines starting with # are skipped.  Throws fs::filesystem_error if the
+// manifest can't be opened.
+std::vector<BatchLine> read_batch_manifest(const S& path);
+
+///////////////////////////////////////////////////////////////////////////////
+// Keeps the log output of concurrent batch jobs readable.  While a BatchLog
+// exists, records logged to default_log() by a job are held until that job
+// and every job before it in the manifest have finished, then written as one
+// block after a notice naming the job's manifest line.  Records logged
+// outside of jobs are written immediately.  Either way, the original log
+// handler is only ever called by one thread at a time.
+class BatchLog final {
+public:
+   explicit BatchLog(const std::vector<BatchLine>& lines);
+   BatchLog(const BatchLog&) = delete;
+   BatchLog& operator=(const BatchLog&) = delete;
+   ~BatchLog();
+
+   // Attributes records logged on the current thread to one job for as long
+   // as it exists.
+   class JobScope final {
+   public:
+      JobScope(BatchLog& log, std::size_t job);
+      JobScope(const JobScope&) = delete;
+      JobScope& operator=(const JobScope&) = delete;
+      ~JobScope();
+
+   private:
+      std::vector<LogRecord>* previous_;
+   };
+
+   // Marks a job as finished, then writes the held records of each finished
+   // job which no longer has unfinished jobs before it.
+   void finish(std::size_t job);
+
+private:
+   void handle_(const LogRecord& rec);
+   void write_finished_();
+
+   const std::vector<BatchLine>& lines_;
+   Log::handler_type previous_handler_;
+   std::recursive_mutex mutex_;
+   std::vector<std::vector<LogRecord>> records_;
+   std::vector<bool> finished_;
+   std::size_t next_to_write_ = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Creates an app for each line with make_app(args), runs each app on a
+// single thread of the pool, then writes the line number and exit code of
+// each job to standard output, separated by a tab, in manifest order.
+// Returns the highest exit code.  Log output is grouped by job through a
+// BatchLog.
+//
+// Command lines are processed up front, on this thread, since the CLI
+// processor adjusts the (shared) log verbosity.  The caller's verbosity is
+// restored afterwards, so -v in the manifest has no effect.
+template <typename MakeApp>
+int run_batch(std::vector<BatchLine>& lines, JobPool& pool, MakeApp make_app) {
+   std::vector<int> statuses(lines.size());
+   {
+      BatchLog log(lines);
+
+      std::vector<decltype(make_app(lines.front().args))> apps;
+      apps.reserve(lines.size());
+      auto verbosity_mask = default_log().verbosity_mask();
+      for (std::size_t i = 0; i < lines.size(); ++i) {
+         BatchLog::JobScope scope(log, i);
+         apps.push_back(make_app(lines[i].args));
+      }
+      default_log().verbosity_mask(verbosity_mask);
+
+      pool.run(apps.size(), [&](std::size_t i) {
+         {
+            BatchLog::JobScope scope(log, i);
+            statuses[i] = (*apps[i])();
+            apps[i].reset();
+         }
+         log.finish(i);
+      });
+   }
+
+   int status = 0;
+   for (std::size_t i = 0; i < lines.size(); ++i) {
+      std::cout << lines[i].line << '\t' << statuses[i] << '\n';
+      status = std::max(status, statuses[i]);
+   }
+   std::cout.flush();
+   return status;
+}
+
+} // be::tools
+
+#endif
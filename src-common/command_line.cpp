@@ -0,0 +1,53 @@
+#include "command_line.hpp"
+
+namespace be::tools {
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<S> split_command_line(const S& line) {
+   std::vector<S> args;
+   S arg;
+   bool in_arg = false;
+   char quote = 0;
+
+   for (char c : line) {
+      if (quote) {
+         if (c == quote) {
+            quote = 0;
+         } else {
+            arg.push_back(c);
+         }
+      } else if (c == '"' || c == '\'') {
+         quote = c;
+         in_arg = true;
+      } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+         if (in_arg) {
+            args.push_back(std::move(arg));
+            arg.clear();
+            in_arg = false;
+         }
+      } else {
+         arg.push_back(c);
+         in_arg = true;
+      }
+   }
+
+   if (in_arg) {
+      args.push_back(std::move(arg));
+   }
+
+   return args;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<char*> make_argv(const char* program, std::vector<S>& args) {
+   std::vector<char*> argv;
+   argv.reserve(args.size() + 2);
+   argv.push_back(const_cast<char*>(program));
+   for (S& arg : args) {
+      argv.push_back(&arg[0]);
+   }
+   argv.push_back(nullptr);
+   return argv;
+}
+
+} // be::tools
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef BE_TOOLS_COMMAND_LINE_HPP_
+#define BE_TOOLS_COMMAND_LINE_HPP_
+
+#include <be/core/be.hpp>
+#include <vector>
+
+namespace be::tools {
+
+///////////////////////////////////////////////////////////////////////////////
+// Splits one line of a --batch manifest or --serve request into arguments.
+// Arguments are separated by whitespace and may be quoted with ' or ".
+std::vector<S> split_command_line(const S& line);
+
+// Builds a null-terminated argv for an app's (int argc, char** argv)
+// constructor; argc is the returned size minus one.  The pointers refer into
+// args, which must outlive the result.
+std::vector<char*> make_argv(const char* program, std::vector<S>& args);
+
+} // be::tools
+
+#endif
@@ -0,0 +1,131 @@
+#include "job_pool.hpp"
+#include <algorithm>
+
+namespace be::tools {
+namespace {
+
+thread_local bool in_job = false;
+
+} // be::tools::()
+
+///////////////////////////////////////////////////////////////////////////////
+JobPool::JobPool(std::size_t concurrency) {
+   if (concurrency == 0) {
+      concurrency = std::max(1u, std::thread::hardware_concurrency());
+   }
+
+   threads_.reserve(concurrency - 1);
+   for (std::size_t i = 1; i < concurrency; ++i) {
+      threads_.emplace_back(&JobPool::worker_, this);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+JobPool::~JobPool() {
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_ = true;
+   }
+   work_cv_.notify_all();
+   for (std::thread& thread : threads_) {
+      thread.join();
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::size_t JobPool::concurrency() const {
+   return threads_.size() + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void JobPool::run(std::size_t jobs, const job_func& func) {
+   if (jobs == 0) {
+      return;
+   }
+
+   if (jobs == 1 || threads_.empty() || in_job) {
+      for (std::size_t job = 0; job < jobs; ++job) {
+         func(job);
+      }
+      return;
+   }
+
+   std::lock_guard<std::mutex> run_lock(run_mutex_);
+
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      func_ = &func;
+      jobs_ = jobs;
+      next_job_ = 0;
+      exception_ = nullptr;
+      busy_workers_ = threads_.size();
+      ++generation_;
+   }
+   work_cv_.notify_all();
+
+   process_jobs_();
+
+   std::exception_ptr exception;
+   {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_cv_.wait(lock, [this]() { return busy_workers_ == 0; });
+      func_ = nullptr;
+      exception = std::move(exception_);
+      exception_ = nullptr;
+   }
+
+   if (exception) {
+      std::rethrow_exception(exception);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void JobPool::worker_() {
+   U64 generation = 0;
+   for (;;) {
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         work_cv_.wait(lock, [&]() { return shutdown_ || generation_ != generation; });
+         if (shutdown_) {
+            return;
+         }
+         generation = generation_;
+      }
+
+      process_jobs_();
+
+      bool done;
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         done = --busy_workers_ == 0;
+      }
+      if (done) {
+         done_cv_.notify_one();
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void JobPool::process_jobs_() {
+   in_job = true;
+   for (;;) {
+      std::size_t job = next_job_.fetch_add(1);
+      if (job >= jobs_) {
+         break;
+      }
+
+      try {
+         (*func_)(job);
+      } catch (...) {
+         std::lock_guard<std::mutex> lock(mutex_);
+         if (!exception_) {
+            exception_ = std::current_exception();
+         }
+         // abandon any jobs which haven't been started yet
+         next_job_ = jobs_;
+      }
+   }
+   in_job = false;
+}
+
+} // be::tools
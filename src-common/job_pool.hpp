@@ -0,0 +1,55 @@
+#pragma once
+#ifndef BE_TOOLS_JOB_POOL_HPP_
+#define BE_TOOLS_JOB_POOL_HPP_
+
+#include <be/core/be.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace be::tools {
+
+///////////////////////////////////////////////////////////////////////////////
+// Fixed set of worker threads which run batches of independent, indexed jobs.
+// The calling thread also runs jobs, so a concurrency of 1 never starts any
+// threads.  Calling run() from inside a job runs the nested batch serially.
+class JobPool final {
+public:
+   using job_func = std::function<void(std::size_t)>;
+
+   explicit JobPool(std::size_t concurrency = 0);
+   JobPool(const JobPool&) = delete;
+   JobPool& operator=(const JobPool&) = delete;
+   ~JobPool();
+
+   std::size_t concurrency() const;
+
+   void run(std::size_t jobs, const job_func& func);
+
+private:
+   void worker_();
+   void process_jobs_();
+
+   std::vector<std::thread> threads_;
+
+   std::mutex run_mutex_;
+   std::mutex mutex_;
+   std::condition_variable work_cv_;
+   std::condition_variable done_cv_;
+   bool shutdown_ = false;
+   U64 generation_ = 0;
+   std::size_t busy_workers_ = 0;
+
+   const job_func* func_ = nullptr;
+   std::size_t jobs_ = 0;
+   std::atomic<std::size_t> next_job_ = 0;
+   std::exception_ptr exception_;
+};
+
+} // be::tools
+
+#endif
@@ -1,20 +1,50 @@
 #include "concur_app.hpp"
+#include "icon_file.hpp"
+#include "png_encoder.hpp"
+#include "resample.hpp"
 #include "version.hpp"
+#include "../src-common/job_pool.hpp"
 #include <be/core/version.hpp>
 #include <be/cli/cli.hpp>
-#include <be/util/get_file_contents.hpp>
 #include <be/util/path_glob.hpp>
 #include <be/util/parse_numeric_string.hpp>
 #include <be/core/logging.hpp>
 #include <be/core/alg.hpp>
 //#include <be/gfx/read_image.hpp>
 //#include <gli/gli.hpp>
-#include <stb/stb_image.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 
 namespace be {
 namespace concur {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+U16 hotspot_pixel(F32 hotspot, U16 size) {
+   return (U16)std::min<F32>(size - 1.f, std::floor(hotspot * size + 0.5f));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Image crop_to_square(const Image& image) {
+   U32 dim = std::min(image.width, image.height);
+   U32 x0 = (image.width - dim) / 2;
+   U32 y0 = (image.height - dim) / 2;
+
+   Image cropped;
+   cropped.width = dim;
+   cropped.height = dim;
+   cropped.pixels.resize((std::size_t)dim * dim * 4);
+   for (U32 y = 0; y < dim; ++y) {
+      const U8* src = image.pixels.data() + (((std::size_t)(y0 + y) * image.width + x0) * 4);
+      std::copy(src, src + (std::size_t)dim * 4, cropped.pixels.data() + (std::size_t)y * dim * 4);
+   }
+   return cropped;
+}
+
+} // be::concur::()
 
 ///////////////////////////////////////////////////////////////////////////////
 ConcurApp::ConcurApp(int argc, char** argv) {
@@ -45,7 +75,8 @@ ConcurApp::ConcurApp(int argc, char** argv) {
                inputs_[str] = input_type::automatic;
             }).desc(Cell() << "Adds the specified path as a source image.")
               .extra(Cell() << nl << "Adding an image does not guarantee that it will be used; use " << fg_yellow << "-s" << reset << " to specify an output image of the same or smaller size."
-                            << "If the image is a PNG image, it will be stored as such in the icon or cursor, even if it is resized.  Otherwise it will be stored as a bitmap."))
+                            << "If the image is a PNG image, it will be stored as such in the icon or cursor, even if it is resized.  Otherwise it will be stored as a bitmap.  "
+                            << "Images which are not square are cropped to the largest centered square, with a warning."))
 
          (param ({ "P", "p" },{ "png" }, "PATH",
             [&](const S& str) {
@@ -105,6 +136,33 @@ ConcurApp::ConcurApp(int argc, char** argv) {
                output_sizes_[256] = hotspot;
             }).desc("Equivalent to -SMNLX"))
 
+         (param ({ }, { "filter" }, "FILTER", [this](const S& str) {
+               if (!parse_resample_filter(str, resample_filter_)) {
+                  throw std::runtime_error("Unrecognized resampling filter: " + str);
+               }
+            }).desc("Specifies the filter used when resizing input images.")
+              .extra(Cell() << "Must be one of " << fg_cyan << "box" << reset << ", " << fg_cyan << "mitchell" << reset << ", or " << fg_cyan << "lanczos3"
+                            << reset << ".  Defaults to " << fg_cyan << "lanczos3" << reset << ".  Resizing is done in linear space, with alpha premultiplied."))
+
+         (numeric_param<U8> ({ "O" }, { "optimize" }, "LEVEL", png_optimize_level_, 0, 3)
+            .default_value(S("2"))
+            .desc("Spends extra time minimizing the size of PNG-encoded output images.")
+            .extra(Cell() << "Each PNG image is re-encoded with several filter and deflate strategies, and the smallest result is kept.  "
+                          << "Images are always stored as 8-bit RGBA, since some icon consumers accept no other PNG format, but the color of fully "
+                          << "transparent pixels may be discarded.  Higher levels try more combinations; "
+                          << fg_cyan << "0" << reset << " disables optimization.  If no level is specified, " << fg_cyan << "2" << reset << " is used."))
+
+         (param ({ }, { "batch" }, "MANIFEST", [&](const S& str) {
+               batch_manifest_ = str;
+            }).desc("Runs each line of a manifest file as a separate concur command line.")
+              .extra(Cell() << nl << "If " << fg_cyan << "MANIFEST" << reset << " is " << fg_cyan << "-" << reset << ", command lines are read from standard input.  "
+                               "Arguments are separated by whitespace and may be quoted with ' or \".  Blank lines and lines starting with # are ignored.  Each line "
+                               "lists the inputs, sizes, hotspots, and output path of one icon or cursor.  Jobs are run concurrently, and each input file is decoded "
+                               "only once, no matter how many jobs use it.  Each job's log output is held and written as one block, labeled with its manifest line, in "
+                               "manifest order.  Once all jobs finish, one line is written to standard output for each job, containing the "
+                               "manifest line number and the job's exit code, separated by a tab.  The batch's exit code is the highest exit code of any job.  No inputs, "
+                               "sizes, or output path may be specified alongside this option, and manifest lines may not use --batch themselves."))
+
          (nth (0,
             [&](const S& str) {
                output_path_ = str;
@@ -153,7 +211,11 @@ ConcurApp::ConcurApp(int argc, char** argv) {
 
       proc.process(argc, argv);
 
-      if (!show_help && !show_version && output_path_.empty()) {
+      if (!batch_manifest_.empty() && (!inputs_.empty() || !output_sizes_.empty() || !output_path_.empty())) {
+         throw std::runtime_error("Inputs, sizes, and output paths can't be specified when using --batch");
+      }
+
+      if (!show_help && !show_version && output_path_.empty() && batch_manifest_.empty()) {
          show_help = true;
          show_version = true;
          status_ = 1;
@@ -213,12 +275,17 @@ int ConcurApp::operator()() {
       return status_;
    }
 
+   if (!batch_manifest_.empty()) {
+      run_batch_();
+      return status_;
+   }
+
    if (output_path_.empty()) {
       return status_;
    }
 
    struct ImageData {
-      //gli::image image;
+      std::shared_ptr<const DecodedSource> decoded;
       input_type type;
    };
 
@@ -232,34 +299,46 @@ int ConcurApp::operator()() {
             be_error() << "Input path does not exist!"
                & attr(ids::log_attr_path) << path
                | default_log();
+            continue;
          } else if (!fs::is_regular_file(path)) {
             status_ = 3;
             be_error() << "Input path is not a file!"
                & attr(ids::log_attr_path) << path
                | default_log();
+            continue;
          }
 
-         /*gli::image png_image = gfx::read_png_image(path);
-         if (!png_image.empty()) {
-            ImageData data { std::move(png_image), pair.second };
-            if (data.type == input_type::automatic) {
-               data.type = input_type::png;
-            }
-            U16 dim = (U16)min(data.image.extent().x, data.image.extent().y);
-            images.emplace(dim, std::move(data));
-         } else {
-            gli::image image = gfx::read_simple_image(path);
-            if (!image.empty()) {
-               ImageData data { std::move(image), pair.second };
-               if (data.type == input_type::automatic) {
-                  data.type = input_type::bitmap;
-               }
-               U16 dim = (U16)min(data.image.extent().x, data.image.extent().y);
-               images.emplace(dim, std::move(data));
-            } else {
-               throw Fatal("Image format not recognized!");
-            }
-         }*/
+         ImageData data { source_cache_ ? source_cache_->get(path) : std::make_shared<const DecodedSource>(decode_source(path)), pair.second };
+         const Image& image = data.decoded->image;
+         if (image.pixels.empty()) {
+            status_ = 4;
+            be_error() << "Image format not recognized!"
+               & attr(ids::log_attr_path) << path
+               | default_log();
+            continue;
+         }
+
+         if (data.type == input_type::automatic) {
+            data.type = data.decoded->png ? input_type::png : input_type::bitmap;
+         }
+
+         if (image.width != image.height) {
+            // Icon and cursor images are always square; rather than stretch
+            // the source, the largest centered square is used.
+            be_warn() << "Input image is not square; cropping to center."
+               & attr(ids::log_attr_path) << path
+               & attr("Width") << image.width
+               & attr("Height") << image.height
+               | default_log();
+
+            auto cropped = std::make_shared<DecodedSource>();
+            cropped->png = data.decoded->png;
+            cropped->image = crop_to_square(image);
+            data.decoded = std::move(cropped);
+         }
+
+         U16 dim = (U16)std::min<U32>(data.decoded->image.width, 0xFFFF);
+         images.emplace(dim, std::move(data));
       }
    } catch (const fs::filesystem_error& e) {
       status_ = 4;
@@ -287,9 +366,172 @@ int ConcurApp::operator()() {
          | default_log();
    }
 
-   // TODO resize images
-   // TODO serialize output images
-   // TODO optimize pngs if necessary
+   if (status_ != 0) {
+      return status_;
+   }
+
+   bool cursor = output_type_ == output_type::cursor;
+   if (output_type_ == output_type::automatic) {
+      S ext = output_path_.extension().string();
+      std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+      cursor = ext == ".cur";
+      for (const auto& pair : output_sizes_) {
+         cursor = cursor || pair.second != glm::vec2();
+      }
+   }
+
+   struct OutputJob {
+      U16 size;
+      glm::vec2 hotspot;
+      const ImageData* source;
+      IconEntry entry;
+      bool optimize_png;
+      PngLayout png_layout;
+   };
+
+   std::vector<OutputJob> jobs;
+   for (const auto& pair : output_sizes_) {
+      auto it = images.lower_bound(pair.first);
+      if (it == images.end()) {
+         be_warn() << "No source image is large enough for output image; skipping."
+            & attr("Size") << pair.first
+            | default_log();
+         continue;
+      }
+      jobs.push_back(OutputJob { pair.first, pair.second, &it->second, IconEntry(), false, PngLayout() });
+   }
+
+   if (jobs.empty()) {
+      status_ = 1;
+      be_error() << "No output images!" | default_log();
+      return status_;
+   }
+
+   // Sources which need resizing are linearized once and reduced to a shared
+   // pyramid, so that each output size costs one resample from a nearby level
+   // no matter how many sizes are derived from the same source.
+   std::map<const ImageData*, std::pair<U16, U16>> size_ranges;
+   for (const OutputJob& job : jobs) {
+      const Image& src = job.source->decoded->image;
+      if (src.width != job.size || src.height != job.size) {
+         auto result = size_ranges.insert(std::make_pair(job.source, std::make_pair(job.size, job.size)));
+         result.first->second.first = std::min(result.first->second.first, job.size);
+         result.first->second.second = std::max(result.first->second.second, job.size);
+      }
+   }
+
+   std::vector<std::pair<const ImageData*, std::pair<U16, U16>>> pyramid_sources(size_ranges.begin(), size_ranges.end());
+   std::vector<ResamplePyramid> pyramids(pyramid_sources.size());
+   std::map<const ImageData*, const ResamplePyramid*> source_pyramids;
+   for (std::size_t i = 0; i < pyramid_sources.size(); ++i) {
+      source_pyramids[pyramid_sources[i].first] = &pyramids[i];
+   }
+
+   try {
+      // Jobs run by --batch share the batch's pool, which runs this work
+      // serially on the job's own thread.
+      std::unique_ptr<tools::JobPool> own_pool;
+      if (!shared_job_pool_) {
+         own_pool = std::make_unique<tools::JobPool>(std::min<std::size_t>(jobs.size(), std::max(1u, std::thread::hardware_concurrency())));
+      }
+      tools::JobPool& pool = shared_job_pool_ ? *shared_job_pool_ : *own_pool;
+      pool.run(pyramid_sources.size(), [&](std::size_t i) {
+         U16 min_size = pyramid_sources[i].second.first;
+         U16 max_size = pyramid_sources[i].second.second;
+         pyramids[i] = build_resample_pyramid(pyramid_sources[i].first->decoded->image, min_size, min_size, max_size, max_size);
+      });
+
+      // Each output image is resized (if necessary) and encoded independently
+      pool.run(jobs.size(), [&](std::size_t i) {
+         OutputJob& job = jobs[i];
+         const Image& src = job.source->decoded->image;
+
+         Image resized;
+         const Image* image = &src;
+         if (src.width != job.size || src.height != job.size) {
+            const LinearImage& level = nearest_pyramid_level(*source_pyramids.at(job.source), job.size, job.size);
+            resized = encode_srgb_image(resample_image(level, job.size, job.size, resample_filter_));
+            image = &resized;
+         }
+
+         job.entry.width = job.size;
+         job.entry.height = job.size;
+         job.entry.hotspot_x = hotspot_pixel(job.hotspot.x, job.size);
+         job.entry.hotspot_y = hotspot_pixel(job.hotspot.y, job.size);
+         job.entry.data = job.source->type == input_type::png ? encode_png(*image) : encode_dib(*image);
+
+         if (png_optimize_level_ > 0 && job.source->type == input_type::png) {
+            job.optimize_png = true;
+            job.png_layout = cleared_rgba_png_layout(*image);
+         }
+      });
+
+      if (png_optimize_level_ > 0) {
+         // Every combination of compression settings for every PNG image is
+         // encoded as a separate job, and the smallest result for each image
+         // replaces the default encoding.
+         struct PngCandidate {
+            std::size_t job;
+            std::size_t compression;
+            std::vector<U8> data;
+         };
+
+         std::vector<PngCompression> compressions = png_optimize_candidates(png_optimize_level_);
+         std::vector<PngCandidate> candidates;
+         std::vector<std::size_t> original_sizes(jobs.size());
+         for (std::size_t j = 0; j < jobs.size(); ++j) {
+            original_sizes[j] = jobs[j].entry.data.size();
+            if (jobs[j].optimize_png) {
+               for (std::size_t c = 0; c < compressions.size(); ++c) {
+                  candidates.push_back(PngCandidate { j, c, std::vector<U8>() });
+               }
+            }
+         }
+
+         pool.run(candidates.size(), [&](std::size_t i) {
+            PngCandidate& candidate = candidates[i];
+            candidate.data = encode_png(jobs[candidate.job].png_layout, compressions[candidate.compression]);
+         });
+
+         for (PngCandidate& candidate : candidates) {
+            IconEntry& entry = jobs[candidate.job].entry;
+            if (candidate.data.size() < entry.data.size()) {
+               entry.data = std::move(candidate.data);
+            }
+         }
+
+         for (std::size_t j = 0; j < jobs.size(); ++j) {
+            if (jobs[j].optimize_png) {
+               be_verbose() << "Optimized PNG image"
+                  & attr("Size") << jobs[j].size
+                  & attr("Original Bytes") << original_sizes[j]
+                  & attr("Optimized Bytes") << jobs[j].entry.data.size()
+                  | default_log();
+            }
+         }
+      }
+   } catch (const FatalTrace& e) {
+      status_ = 1;
+      be_error() << "Fatal error while encoding images!"
+         & attr(ids::log_attr_message) << S(e.what())
+         & attr(ids::log_attr_trace) << StackTrace(e.trace())
+         | default_log();
+   } catch (const RecoverableTrace& e) {
+      status_ = 1;
+      be_error() << "Error while encoding images!"
+         & attr(ids::log_attr_message) << S(e.what())
+         & attr(ids::log_attr_trace) << StackTrace(e.trace())
+         | default_log();
+   } catch (const std::exception& e) {
+      status_ = 1;
+      be_error() << "Unexpected exception while encoding images!"
+         & attr(ids::log_attr_message) << S(e.what())
+         | default_log();
+   }
+
+   if (status_ != 0) {
+      return status_;
+   }
 
    try {
       output_path_ = fs::absolute(output_path_);
@@ -306,13 +548,24 @@ int ConcurApp::operator()() {
 
       be_short_verbose() << "Output path: " << color::fg_gray << output_path_.generic_string() | default_log();
 
+      if (status_ == 0) {
+         std::vector<IconEntry> entries;
+         entries.reserve(jobs.size());
+         for (OutputJob& job : jobs) {
+            entries.push_back(std::move(job.entry));
+         }
 
-
-
-
-
-
-      // TODO write ico/cur
+         std::vector<U8> data = serialize_icon(entries, cursor);
+         std::ofstream ofs(output_path_.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+         ofs.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+         ofs.close();
+         if (!ofs) {
+            status_ = 5;
+            be_error() << "Failed to write output file!"
+               & attr(ids::log_attr_path) << output_path_
+               | default_log();
+         }
+      }
    } catch (const fs::filesystem_error& e) {
       status_ = 1;
       be_error() << "Filesystem error while configuring paths!"
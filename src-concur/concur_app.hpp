@@ -2,9 +2,14 @@
 #ifndef BE_CONCUR_CONCUR_APP_HPP_
 #define BE_CONCUR_CONCUR_APP_HPP_
 
+#include "resample.hpp"
+#include "source_cache.hpp"
+#include "../src-common/job_pool.hpp"
 #include <be/core/lifecycle.hpp>
 #include <be/core/filesystem.hpp>
 #include <map>
+#include <memory>
+#include <vector>
 #include <glm/vec2.hpp>
 
 namespace be {
@@ -31,6 +36,9 @@ private:
       cursor
    };
 
+   std::unique_ptr<ConcurApp> make_job_app_(std::vector<S>& args, tools::JobPool& pool, SourceCache& cache);
+   void run_batch_();
+
    CoreInitLifecycle init_;
    I8 status_ = 0;
 
@@ -38,6 +46,12 @@ private:
    Path output_path_;
    output_type output_type_ = output_type::automatic;
    std::map<U16, glm::vec2> output_sizes_;
+   ResampleFilter resample_filter_ = ResampleFilter::lanczos3;
+   U8 png_optimize_level_ = 0;
+
+   S batch_manifest_;
+   tools::JobPool* shared_job_pool_ = nullptr; // set for jobs run by --batch
+   SourceCache* source_cache_ = nullptr; // set for jobs run by --batch
 
 };
 
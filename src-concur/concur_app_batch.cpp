@@ -0,0 +1,62 @@
+#include "concur_app.hpp"
+#include "../src-common/batch.hpp"
+#include "../src-common/command_line.hpp"
+#include <be/core/log_exception.hpp>
+#include <be/core/logging.hpp>
+#include <algorithm>
+
+namespace be {
+namespace concur {
+
+///////////////////////////////////////////////////////////////////////////////
+std::unique_ptr<ConcurApp> ConcurApp::make_job_app_(std::vector<S>& args, tools::JobPool& pool, SourceCache& cache) {
+   std::vector<char*> argv = tools::make_argv("concur", args);
+   auto app = std::make_unique<ConcurApp>(int(argv.size() - 1), argv.data());
+   app->shared_job_pool_ = &pool;
+   app->source_cache_ = &cache;
+
+   // Jobs run on the batch's pool, which a nested batch would tie up.
+   if (!app->batch_manifest_.empty()) {
+      app->status_ = 2;
+      be_error() << "--batch can't be used within a batch manifest!" | default_log();
+   }
+
+   // Jobs which will read inputs are counted before any job runs, so that
+   // the cache can drop each decoded input after its last reader fetches it.
+   if (app->status_ == 0 && !app->output_path_.empty()) {
+      for (const auto& pair : app->inputs_) {
+         cache.expect(pair.first);
+      }
+   }
+
+   return app;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void ConcurApp::run_batch_() {
+   std::vector<tools::BatchLine> lines;
+   try {
+      lines = tools::read_batch_manifest(batch_manifest_);
+   } catch (const fs::filesystem_error& e) {
+      status_ = 4;
+      log_exception(e);
+      return;
+   }
+
+   be_verbose() << "Running batch"
+      & attr("Manifest") << batch_manifest_
+      & attr("Jobs") << lines.size()
+      | default_log();
+
+   // Each job runs on a single thread of the pool; decoded input files are
+   // shared through the cache until the last job using them has read them.
+   tools::JobPool pool;
+   SourceCache cache;
+   int status = tools::run_batch(lines, pool, [&](std::vector<S>& args) {
+      return make_job_app_(args, pool, cache);
+   });
+   status_ = std::max<I8>(status_, I8(status));
+}
+
+} // be::concur
+} // be
@@ -0,0 +1,106 @@
+#include "icon_file.hpp"
+
+namespace be {
+namespace concur {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+void append_u16(std::vector<U8>& out, U16 value) {
+   out.push_back(U8(value));
+   out.push_back(U8(value >> 8));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void append_u32(std::vector<U8>& out, U32 value) {
+   append_u16(out, U16(value));
+   append_u16(out, U16(value >> 16));
+}
+
+} // be::concur::()
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<U8> encode_dib(const Image& image) {
+   const std::size_t mask_row_size = ((image.width + 31) / 32) * 4;
+   const std::size_t pixel_size = std::size_t(image.width) * image.height * 4;
+   const std::size_t mask_size = mask_row_size * image.height;
+
+   std::vector<U8> out;
+   out.reserve(40 + pixel_size + mask_size);
+
+   // BITMAPINFOHEADER; the height covers both the XOR (color) and AND masks
+   append_u32(out, 40);
+   append_u32(out, image.width);
+   append_u32(out, image.height * 2);
+   append_u16(out, 1);  // planes
+   append_u16(out, 32); // bits per pixel
+   append_u32(out, 0);  // BI_RGB
+   append_u32(out, U32(pixel_size + mask_size));
+   append_u32(out, 0);  // horizontal resolution
+   append_u32(out, 0);  // vertical resolution
+   append_u32(out, 0);  // palette colors
+   append_u32(out, 0);  // important colors
+
+   for (U32 y = image.height; y-- > 0; ) {
+      const U8* row = image.pixels.data() + std::size_t(y) * image.width * 4;
+      for (U32 x = 0; x < image.width; ++x) {
+         const U8* p = row + x * 4;
+         out.push_back(p[2]);
+         out.push_back(p[1]);
+         out.push_back(p[0]);
+         out.push_back(p[3]);
+      }
+   }
+
+   for (U32 y = image.height; y-- > 0; ) {
+      const U8* row = image.pixels.data() + std::size_t(y) * image.width * 4;
+      std::size_t row_offset = out.size();
+      out.resize(out.size() + mask_row_size);
+      for (U32 x = 0; x < image.width; ++x) {
+         if (row[x * 4 + 3] == 0) {
+            out[row_offset + x / 8] |= U8(0x80 >> (x % 8));
+         }
+      }
+   }
+
+   return out;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<U8> serialize_icon(const std::vector<IconEntry>& entries, bool cursor) {
+   std::size_t total_size = 6 + 16 * entries.size();
+   for (const IconEntry& entry : entries) {
+      total_size += entry.data.size();
+   }
+
+   std::vector<U8> out;
+   out.reserve(total_size);
+
+   // ICONDIR
+   append_u16(out, 0);
+   append_u16(out, cursor ? 2 : 1);
+   append_u16(out, U16(entries.size()));
+
+   // ICONDIRENTRY; a width or height of 256 is stored as 0.  Cursors store
+   // the hotspot in place of the color planes and bit count.
+   U32 offset = U32(6 + 16 * entries.size());
+   for (const IconEntry& entry : entries) {
+      out.push_back(U8(entry.width));
+      out.push_back(U8(entry.height));
+      out.push_back(0); // palette colors
+      out.push_back(0); // reserved
+      append_u16(out, cursor ? entry.hotspot_x : 1);
+      append_u16(out, cursor ? entry.hotspot_y : 32);
+      append_u32(out, U32(entry.data.size()));
+      append_u32(out, offset);
+      offset += U32(entry.data.size());
+   }
+
+   for (const IconEntry& entry : entries) {
+      out.insert(out.end(), entry.data.begin(), entry.data.end());
+   }
+
+   return out;
+}
+
+} // be::concur
+} // be
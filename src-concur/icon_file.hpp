@@ -0,0 +1,33 @@
+#pragma once
+#ifndef BE_CONCUR_ICON_FILE_HPP_
+#define BE_CONCUR_ICON_FILE_HPP_
+
+#include "image.hpp"
+
+namespace be {
+namespace concur {
+
+///////////////////////////////////////////////////////////////////////////////
+// Encodes an image as an icon/cursor DIB: a BITMAPINFOHEADER with doubled
+// height, 32-bit BGRA rows stored bottom-up, and a 1-bit AND mask which is
+// set wherever the image is fully transparent.
+std::vector<U8> encode_dib(const Image& image);
+
+///////////////////////////////////////////////////////////////////////////////
+struct IconEntry {
+   U16 width = 0;
+   U16 height = 0;
+   U16 hotspot_x = 0; // cursors only
+   U16 hotspot_y = 0; // cursors only
+   std::vector<U8> data; // PNG file or DIB
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Builds a complete .ico or .cur file: the ICONDIR header, one directory
+// entry per image, then each image's data, in the order given.
+std::vector<U8> serialize_icon(const std::vector<IconEntry>& entries, bool cursor);
+
+} // be::concur
+} // be
+
+#endif
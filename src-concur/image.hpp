@@ -0,0 +1,23 @@
+#pragma once
+#ifndef BE_CONCUR_IMAGE_HPP_
+#define BE_CONCUR_IMAGE_HPP_
+
+#include <be/core/be.hpp>
+#include <vector>
+
+namespace be {
+namespace concur {
+
+///////////////////////////////////////////////////////////////////////////////
+// 8-bit RGBA pixels with straight (unpremultiplied) alpha, top row first,
+// with no padding between rows.
+struct Image {
+   U32 width = 0;
+   U32 height = 0;
+   std::vector<U8> pixels;
+};
+
+} // be::concur
+} // be
+
+#endif
@@ -0,0 +1,193 @@
+#include "png_encoder.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+namespace be {
+namespace concur {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+void append_be_u32(std::vector<U8>& out, U32 value) {
+   out.push_back(U8(value >> 24));
+   out.push_back(U8(value >> 16));
+   out.push_back(U8(value >> 8));
+   out.push_back(U8(value));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void append_chunk(std::vector<U8>& out, const char* type, const U8* data, std::size_t size) {
+   append_be_u32(out, U32(size));
+   std::size_t type_offset = out.size();
+   out.insert(out.end(), type, type + 4);
+   out.insert(out.end(), data, data + size);
+   uLong crc = crc32(0, out.data() + type_offset, uInt(4 + size));
+   append_be_u32(out, U32(crc));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U8 paeth(U8 a, U8 b, U8 c) {
+   int p = int(a) + b - c;
+   int pa = std::abs(p - a);
+   int pb = std::abs(p - b);
+   int pc = std::abs(p - c);
+   if (pa <= pb && pa <= pc) {
+      return a;
+   }
+   return pb <= pc ? b : c;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void filter_row(U8 filter, const U8* row, const U8* prev, std::size_t size, std::size_t bpp, U8* out) {
+   for (std::size_t i = 0; i < size; ++i) {
+      U8 a = i >= bpp ? row[i - bpp] : 0;
+      U8 b = prev ? prev[i] : 0;
+      U8 c = prev && i >= bpp ? prev[i - bpp] : 0;
+      switch (filter) {
+         case 0: out[i] = row[i]; break;
+         case 1: out[i] = U8(row[i] - a); break;
+         case 2: out[i] = U8(row[i] - b); break;
+         case 3: out[i] = U8(row[i] - ((a + b) >> 1)); break;
+         default: out[i] = U8(row[i] - paeth(a, b, c)); break;
+      }
+   }
+}
+
+} // be::concur::()
+
+///////////////////////////////////////////////////////////////////////////////
+PngLayout rgba_png_layout(const Image& image) {
+   PngLayout layout;
+   layout.width = image.width;
+   layout.height = image.height;
+   layout.row_size = std::size_t(image.width) * 4;
+   layout.rows = image.pixels;
+   return layout;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+PngLayout cleared_rgba_png_layout(const Image& image) {
+   PngLayout layout = rgba_png_layout(image);
+   for (std::size_t i = 0, n = layout.rows.size(); i < n; i += 4) {
+      if (layout.rows[i + 3] == 0) {
+         std::fill_n(layout.rows.data() + i, 4, U8(0));
+      }
+   }
+   return layout;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<PngCompression> png_optimize_candidates(U8 level) {
+   std::vector<PngFilter> filters { PngFilter::none, PngFilter::adaptive };
+   std::vector<PngDeflateStrategy> strategies { PngDeflateStrategy::normal };
+   std::vector<U8> mem_levels { 8 };
+
+   if (level >= 2) {
+      filters = { PngFilter::none, PngFilter::sub, PngFilter::up, PngFilter::average, PngFilter::paeth, PngFilter::adaptive };
+      strategies.push_back(PngDeflateStrategy::filtered);
+      mem_levels = { 9 };
+   }
+
+   if (level >= 3) {
+      strategies.push_back(PngDeflateStrategy::rle);
+      strategies.push_back(PngDeflateStrategy::huffman_only);
+      mem_levels = { 8, 9 };
+   }
+
+   std::vector<PngCompression> candidates;
+   for (PngFilter filter : filters) {
+      for (PngDeflateStrategy strategy : strategies) {
+         for (U8 mem_level : mem_levels) {
+            candidates.push_back(PngCompression { filter, strategy, 9, mem_level });
+         }
+      }
+   }
+   return candidates;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<U8> encode_png(const PngLayout& layout, const PngCompression& compression) {
+   const std::size_t row_size = layout.row_size;
+   const std::size_t bpp = 4;
+
+   std::vector<U8> filtered((row_size + 1) * layout.height);
+   std::vector<U8> candidate(row_size);
+   for (U32 y = 0; y < layout.height; ++y) {
+      const U8* row = layout.rows.data() + y * row_size;
+      const U8* prev = y > 0 ? row - row_size : nullptr;
+      U8* out = filtered.data() + y * (row_size + 1);
+
+      if (compression.filter != PngFilter::adaptive) {
+         out[0] = U8(compression.filter);
+         filter_row(out[0], row, prev, row_size, bpp, out + 1);
+         continue;
+      }
+
+      // Each row is prefixed with the filter which gives the smallest sum of
+      // absolute (signed) values, the usual heuristic for good compression.
+      U64 best_score = ~U64(0);
+      for (U8 filter = 0; filter < 5; ++filter) {
+         filter_row(filter, row, prev, row_size, bpp, candidate.data());
+         U64 score = 0;
+         for (U8 v : candidate) {
+            score += v < 128 ? v : 256 - v;
+         }
+         if (score < best_score) {
+            best_score = score;
+            out[0] = filter;
+            std::copy(candidate.begin(), candidate.end(), out + 1);
+         }
+      }
+   }
+
+   int strategy = Z_DEFAULT_STRATEGY;
+   switch (compression.strategy) {
+      case PngDeflateStrategy::filtered:     strategy = Z_FILTERED; break;
+      case PngDeflateStrategy::rle:          strategy = Z_RLE; break;
+      case PngDeflateStrategy::huffman_only: strategy = Z_HUFFMAN_ONLY; break;
+      default: break;
+   }
+
+   z_stream stream = { };
+   if (deflateInit2(&stream, compression.level, Z_DEFLATED, 15, compression.mem_level, strategy) != Z_OK) {
+      throw std::runtime_error("Failed to initialize PNG compressor!");
+   }
+   std::vector<U8> compressed(deflateBound(&stream, uLong(filtered.size())));
+   stream.next_in = filtered.data();
+   stream.avail_in = uInt(filtered.size());
+   stream.next_out = compressed.data();
+   stream.avail_out = uInt(compressed.size());
+   int result = deflate(&stream, Z_FINISH);
+   std::size_t compressed_size = stream.total_out;
+   deflateEnd(&stream);
+   if (result != Z_STREAM_END) {
+      throw std::runtime_error("Failed to compress PNG image data!");
+   }
+
+   std::vector<U8> ihdr;
+   append_be_u32(ihdr, layout.width);
+   append_be_u32(ihdr, layout.height);
+   ihdr.push_back(8); // bit depth
+   ihdr.push_back(6); // color type: RGBA
+   ihdr.push_back(0); // compression method
+   ihdr.push_back(0); // filter method
+   ihdr.push_back(0); // interlace method
+
+   static const U8 signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+   std::vector<U8> out(signature, signature + sizeof(signature));
+   out.reserve(sizeof(signature) + 3 * 12 + ihdr.size() + compressed_size);
+   append_chunk(out, "IHDR", ihdr.data(), ihdr.size());
+   append_chunk(out, "IDAT", compressed.data(), compressed_size);
+   append_chunk(out, "IEND", nullptr, 0);
+   return out;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::vector<U8> encode_png(const Image& image) {
+   return encode_png(rgba_png_layout(image), PngCompression());
+}
+
+} // be::concur
+} // be
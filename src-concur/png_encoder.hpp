@@ -0,0 +1,67 @@
+#pragma once
+#ifndef BE_CONCUR_PNG_ENCODER_HPP_
+#define BE_CONCUR_PNG_ENCODER_HPP_
+
+#include "image.hpp"
+
+namespace be {
+namespace concur {
+
+///////////////////////////////////////////////////////////////////////////////
+// 8-bit RGBA scanlines, not yet filtered.  Icon and cursor consumers are not
+// required to accept any other PNG color type or bit depth, so no other
+// layouts are produced.
+struct PngLayout {
+   U32 width = 0;
+   U32 height = 0;
+   std::size_t row_size = 0;
+   std::vector<U8> rows;
+};
+
+// The layout used by encode_png(const Image&).
+PngLayout rgba_png_layout(const Image& image);
+
+// The same layout, but with fully transparent pixels stored as transparent
+// black, which usually compresses better.  The color of fully transparent
+// pixels is not considered significant.
+PngLayout cleared_rgba_png_layout(const Image& image);
+
+///////////////////////////////////////////////////////////////////////////////
+enum class PngFilter : U8 {
+   none = 0,
+   sub,
+   up,
+   average,
+   paeth,
+   adaptive // per row, whichever minimizes the sum of absolute filtered values
+};
+
+enum class PngDeflateStrategy : U8 {
+   normal,
+   filtered,
+   rle,
+   huffman_only
+};
+
+struct PngCompression {
+   PngFilter filter = PngFilter::adaptive;
+   PngDeflateStrategy strategy = PngDeflateStrategy::normal;
+   U8 level = 9;
+   U8 mem_level = 8;
+};
+
+// The filter/deflate combinations tried by --optimize at the given level
+// (1-3); higher levels try more combinations.
+std::vector<PngCompression> png_optimize_candidates(U8 level);
+
+///////////////////////////////////////////////////////////////////////////////
+// Encodes a complete PNG file.
+std::vector<U8> encode_png(const PngLayout& layout, const PngCompression& compression);
+
+// Encodes an image as an 8-bit RGBA PNG file with the default compression.
+std::vector<U8> encode_png(const Image& image);
+
+} // be::concur
+} // be
+
+#endif
@@ -0,0 +1,679 @@
+#include "resample.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BE_CONCUR_RESAMPLE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP) && _M_IX86_FP >= 2
+#define BE_CONCUR_RESAMPLE_SSE2
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BE_CONCUR_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BE_CONCUR_TARGET(isa)
+#endif
+
+namespace be {
+namespace concur {
+namespace {
+
+constexpr F64 pi = 3.14159265358979323846;
+
+///////////////////////////////////////////////////////////////////////////////
+bool detect_avx2() {
+#if defined(BE_CONCUR_RESAMPLE_X86) && defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 0);
+   int max_leaf = info[0];
+   __cpuid(info, 1);
+   bool os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+   if (max_leaf >= 7 && os_avx) {
+      __cpuidex(info, 7, 0);
+      return (info[1] & (1 << 5)) != 0;
+   }
+   return false;
+#elif defined(BE_CONCUR_RESAMPLE_X86)
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2");
+#else
+   return false;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool has_avx2() {
+   static const bool avx2 = detect_avx2();
+   return avx2;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+F64 filter_radius(ResampleFilter filter) {
+   switch (filter) {
+      case ResampleFilter::box:      return 0.5;
+      case ResampleFilter::mitchell: return 2.0;
+      default:                       return 3.0;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+F64 sinc(F64 x) {
+   if (x == 0) {
+      return 1;
+   }
+   x *= pi;
+   return std::sin(x) / x;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+F64 filter_value(ResampleFilter filter, F64 x) {
+   x = std::abs(x);
+   switch (filter) {
+      case ResampleFilter::box:
+         return x < 0.5 ? 1 : 0;
+
+      case ResampleFilter::mitchell:
+      {
+         constexpr F64 b = 1.0 / 3.0;
+         constexpr F64 c = 1.0 / 3.0;
+         if (x < 1) {
+            return ((12 - 9 * b - 6 * c) * x * x * x + (-18 + 12 * b + 6 * c) * x * x + (6 - 2 * b)) / 6;
+         } else if (x < 2) {
+            return ((-b - 6 * c) * x * x * x + (6 * b + 30 * c) * x * x + (-12 * b - 48 * c) * x + (8 * b + 24 * c)) / 6;
+         }
+         return 0;
+      }
+
+      default:
+         return x < 3 ? sinc(x) * sinc(x / 3) : 0;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Every destination pixel reads the same number of consecutive source
+// pixels, starting at first[i], so the passes below have no edge cases.
+struct Weights {
+   U32 taps = 0;
+   std::vector<U32> first;
+   std::vector<F32> weights; // taps per destination pixel
+};
+
+///////////////////////////////////////////////////////////////////////////////
+Weights compute_weights(U32 src_size, U32 dest_size, ResampleFilter filter) {
+   F64 scale = F64(src_size) / F64(dest_size);
+   F64 filter_scale = std::max(1.0, scale);
+   F64 support = filter_radius(filter) * filter_scale;
+
+   Weights result;
+   result.taps = std::min(src_size, U32(std::ceil(support * 2)) + 1);
+   result.first.resize(dest_size);
+   result.weights.assign(std::size_t(dest_size) * result.taps, 0.f);
+
+   for (U32 i = 0; i < dest_size; ++i) {
+      F64 center = (i + 0.5) * scale;
+      I64 lo = std::max<I64>(0, I64(std::ceil(center - support - 0.5)));
+      I64 hi = std::min<I64>(I64(src_size) - 1, I64(std::floor(center + support - 0.5)));
+      hi = std::min<I64>(hi, lo + result.taps - 1);
+
+      U32 first = U32(std::min<I64>(lo, I64(src_size) - result.taps));
+      F32* w = result.weights.data() + std::size_t(i) * result.taps;
+      result.first[i] = first;
+
+      F64 total = 0;
+      for (I64 j = lo; j <= hi; ++j) {
+         F64 value = filter_value(filter, (j + 0.5 - center) / filter_scale);
+         w[j - first] = F32(value);
+         total += value;
+      }
+
+      if (total == 0) {
+         I64 nearest = std::min<I64>(I64(src_size) - 1, I64(center));
+         w[nearest - first] = 1.f;
+      } else {
+         for (U32 t = 0; t < result.taps; ++t) {
+            w[t] = F32(w[t] / total);
+         }
+      }
+   }
+
+   return result;
+}
+
+#ifndef BE_CONCUR_RESAMPLE_SSE2
+///////////////////////////////////////////////////////////////////////////////
+void horizontal_row_generic(const F32* src, F32* dest, U32 dest_width, const Weights& w) {
+   for (U32 x = 0; x < dest_width; ++x) {
+      const F32* s = src + std::size_t(w.first[x]) * 4;
+      const F32* weights = w.weights.data() + std::size_t(x) * w.taps;
+      F32 sum[4] = { };
+      for (U32 t = 0; t < w.taps; ++t) {
+         for (std::size_t c = 0; c < 4; ++c) {
+            sum[c] += weights[t] * s[t * 4 + c];
+         }
+      }
+      std::copy(sum, sum + 4, dest + std::size_t(x) * 4);
+   }
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+void vertical_row_generic(const F32* src, std::size_t src_stride, F32* dest, std::size_t floats, const F32* weights, U32 taps) {
+   for (std::size_t i = 0; i < floats; ++i) {
+      F32 sum = 0;
+      for (U32 t = 0; t < taps; ++t) {
+         sum += weights[t] * src[t * src_stride + i];
+      }
+      dest[i] = sum;
+   }
+}
+
+#ifdef BE_CONCUR_RESAMPLE_SSE2
+///////////////////////////////////////////////////////////////////////////////
+// One RGBA pixel per register
+void horizontal_row_sse2(const F32* src, F32* dest, U32 dest_width, const Weights& w) {
+   for (U32 x = 0; x < dest_width; ++x) {
+      const F32* s = src + std::size_t(w.first[x]) * 4;
+      const F32* weights = w.weights.data() + std::size_t(x) * w.taps;
+      __m128 sum = _mm_setzero_ps();
+      for (U32 t = 0; t < w.taps; ++t) {
+         sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(s + t * 4)));
+      }
+      _mm_storeu_ps(dest + std::size_t(x) * 4, sum);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void vertical_row_sse2(const F32* src, std::size_t src_stride, F32* dest, std::size_t floats, const F32* weights, U32 taps) {
+   std::size_t i = 0;
+   for (; i + 4 <= floats; i += 4) {
+      __m128 sum = _mm_setzero_ps();
+      for (U32 t = 0; t < taps; ++t) {
+         sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(src + t * src_stride + i)));
+      }
+      _mm_storeu_ps(dest + i, sum);
+   }
+   vertical_row_generic(src + i, src_stride, dest + i, floats - i, weights, taps);
+}
+#endif
+
+#ifdef BE_CONCUR_RESAMPLE_X86
+///////////////////////////////////////////////////////////////////////////////
+// Two consecutive taps per register; the halves are summed at the end.
+BE_CONCUR_TARGET("avx2")
+void horizontal_row_avx2(const F32* src, F32* dest, U32 dest_width, const Weights& w) {
+   for (U32 x = 0; x < dest_width; ++x) {
+      const F32* s = src + std::size_t(w.first[x]) * 4;
+      const F32* weights = w.weights.data() + std::size_t(x) * w.taps;
+      __m256 sum2 = _mm256_setzero_ps();
+      U32 t = 0;
+      for (; t + 2 <= w.taps; t += 2) {
+         __m256 wt = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weights[t])), _mm_set1_ps(weights[t + 1]), 1);
+         sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(wt, _mm256_loadu_ps(s + t * 4)));
+      }
+      __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum2), _mm256_extractf128_ps(sum2, 1));
+      if (t < w.taps) {
+         sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(s + t * 4)));
+      }
+      _mm_storeu_ps(dest + std::size_t(x) * 4, sum);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_CONCUR_TARGET("avx2")
+void vertical_row_avx2(const F32* src, std::size_t src_stride, F32* dest, std::size_t floats, const F32* weights, U32 taps) {
+   std::size_t i = 0;
+   for (; i + 8 <= floats; i += 8) {
+      __m256 sum = _mm256_setzero_ps();
+      for (U32 t = 0; t < taps; ++t) {
+         sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(src + t * src_stride + i)));
+      }
+      _mm256_storeu_ps(dest + i, sum);
+   }
+   vertical_row_generic(src + i, src_stride, dest + i, floats - i, weights, taps);
+}
+#endif
+
+using horizontal_row_func = void(*)(const F32*, F32*, U32, const Weights&);
+using vertical_row_func = void(*)(const F32*, std::size_t, F32*, std::size_t, const F32*, U32);
+
+///////////////////////////////////////////////////////////////////////////////
+horizontal_row_func find_horizontal_row_func() {
+#ifdef BE_CONCUR_RESAMPLE_X86
+   if (has_avx2()) {
+      return horizontal_row_avx2;
+   }
+#endif
+#ifdef BE_CONCUR_RESAMPLE_SSE2
+   return horizontal_row_sse2;
+#else
+   return horizontal_row_generic;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+vertical_row_func find_vertical_row_func() {
+#ifdef BE_CONCUR_RESAMPLE_X86
+   if (has_avx2()) {
+      return vertical_row_avx2;
+   }
+#endif
+#ifdef BE_CONCUR_RESAMPLE_SSE2
+   return vertical_row_sse2;
+#else
+   return vertical_row_generic;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const F32* srgb_to_linear_lut() {
+   static const std::array<F32, 256> lut = []() {
+      std::array<F32, 256> table;
+      for (std::size_t i = 0; i < 256; ++i) {
+         F64 c = F64(i) / 255.0;
+         table[i] = F32(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+      }
+      return table;
+   }();
+   return lut.data();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// thresholds[i] is the linear value halfway between sRGB codes i and i + 1,
+// so the number of thresholds below a value is its correctly rounded code.
+const F32* linear_to_srgb_thresholds() {
+   static const std::array<F32, 255> thresholds = []() {
+      std::array<F32, 255> table;
+      for (std::size_t i = 0; i < 255; ++i) {
+         F64 c = (i + 0.5) / 255.0;
+         table[i] = F32(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+      }
+      return table;
+   }();
+   return thresholds.data();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// first_codes[b] is the number of thresholds at or below b / 4096.  The
+// buckets are narrower than the gap between any two thresholds, so at most
+// a couple of comparisons are needed to find the exact code from there.
+constexpr std::size_t linear_to_srgb_buckets = 4096;
+
+const U8* linear_to_srgb_first_codes() {
+   static const std::array<U8, linear_to_srgb_buckets> first_codes = []() {
+      const F32* thresholds = linear_to_srgb_thresholds();
+      std::array<U8, linear_to_srgb_buckets> table;
+      for (std::size_t b = 0; b < linear_to_srgb_buckets; ++b) {
+         F32 value = F32(b) / F32(linear_to_srgb_buckets);
+         table[b] = U8(std::upper_bound(thresholds, thresholds + 255, value) - thresholds);
+      }
+      return table;
+   }();
+   return first_codes.data();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+U8 linear_to_srgb(F32 value, const F32* thresholds, const U8* first_codes) {
+   if (!(value > 0.f)) {
+      return 0;
+   }
+   std::size_t bucket = std::min(linear_to_srgb_buckets - 1, std::size_t(std::min(value, 1.f) * F32(linear_to_srgb_buckets)));
+   std::size_t code = first_codes[bucket];
+   while (code < 255 && thresholds[code] <= value) {
+      ++code;
+   }
+   return U8(code);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The *downsample_row_* functions produce one row of a 2x box reduction from
+// the source rows r0 and r1.  The linearize variants read sRGB8 pixels and
+// premultiply alpha before averaging, so that the full resolution source
+// never needs to be stored as floats.
+#ifndef BE_CONCUR_RESAMPLE_SSE2
+void linearize_pixels_generic(const U8* src, F32* dest, std::size_t pixels, const F32* lut) {
+   for (std::size_t i = 0; i < pixels * 4; i += 4) {
+      F32 alpha = src[i + 3] * (1.f / 255.f);
+      dest[i + 0] = lut[src[i + 0]] * alpha;
+      dest[i + 1] = lut[src[i + 1]] * alpha;
+      dest[i + 2] = lut[src[i + 2]] * alpha;
+      dest[i + 3] = alpha;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void linearize_downsample_row_generic(const U8* r0, const U8* r1, F32* dest, U32 dest_width, const F32* lut) {
+   for (std::size_t x = 0; x < dest_width; ++x) {
+      const std::size_t i = x * 8;
+      const U8* pixels[4] = { r0 + i, r0 + i + 4, r1 + i, r1 + i + 4 };
+      F32 sum[4] = { };
+      for (const U8* p : pixels) {
+         F32 alpha = p[3] * (1.f / 255.f);
+         sum[0] += lut[p[0]] * alpha;
+         sum[1] += lut[p[1]] * alpha;
+         sum[2] += lut[p[2]] * alpha;
+         sum[3] += alpha;
+      }
+      for (std::size_t c = 0; c < 4; ++c) {
+         dest[x * 4 + c] = sum[c] * 0.25f;
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void downsample_row_generic(const F32* r0, const F32* r1, F32* dest, U32 dest_width) {
+   for (std::size_t x = 0; x < dest_width * 4; x += 4) {
+      const std::size_t i = x * 2;
+      for (std::size_t c = 0; c < 4; ++c) {
+         dest[x + c] = (r0[i + c] + r0[i + 4 + c] + r1[i + c] + r1[i + 4 + c]) * 0.25f;
+      }
+   }
+}
+#endif
+
+#ifdef BE_CONCUR_RESAMPLE_SSE2
+///////////////////////////////////////////////////////////////////////////////
+// The LUT lookups are scalar, but each pixel is premultiplied and stored
+// with a single multiply and store; alpha is premultiplied by 1.
+inline __m128 linearize_pixel_sse2(const U8* p, const F32* lut) {
+   return _mm_mul_ps(_mm_setr_ps(lut[p[0]], lut[p[1]], lut[p[2]], 1.f), _mm_set1_ps(p[3] * (1.f / 255.f)));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void linearize_pixels_sse2(const U8* src, F32* dest, std::size_t pixels, const F32* lut) {
+   for (std::size_t i = 0; i < pixels * 4; i += 4) {
+      _mm_storeu_ps(dest + i, linearize_pixel_sse2(src + i, lut));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void linearize_downsample_row_sse2(const U8* r0, const U8* r1, F32* dest, U32 dest_width, const F32* lut) {
+   const __m128 quarter = _mm_set1_ps(0.25f);
+   for (std::size_t x = 0; x < dest_width; ++x) {
+      const std::size_t i = x * 8;
+      __m128 top = _mm_add_ps(linearize_pixel_sse2(r0 + i, lut), linearize_pixel_sse2(r0 + i + 4, lut));
+      __m128 bottom = _mm_add_ps(linearize_pixel_sse2(r1 + i, lut), linearize_pixel_sse2(r1 + i + 4, lut));
+      _mm_storeu_ps(dest + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// One RGBA pixel per register
+void downsample_row_sse2(const F32* r0, const F32* r1, F32* dest, U32 dest_width) {
+   const __m128 quarter = _mm_set1_ps(0.25f);
+   for (std::size_t x = 0; x < dest_width; ++x) {
+      const std::size_t i = x * 8;
+      __m128 left = _mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r1 + i));
+      __m128 right = _mm_add_ps(_mm_loadu_ps(r0 + i + 4), _mm_loadu_ps(r1 + i + 4));
+      _mm_storeu_ps(dest + x * 4, _mm_mul_ps(_mm_add_ps(left, right), quarter));
+   }
+}
+#endif
+
+#ifdef BE_CONCUR_RESAMPLE_X86
+///////////////////////////////////////////////////////////////////////////////
+// Two horizontally adjacent source pixels per register; the color channels
+// are looked up with a gather and alpha is broadcast within each pixel.
+BE_CONCUR_TARGET("avx2")
+inline __m256 linearize_pixel_pair_avx2(const U8* p, const F32* lut) {
+   __m256i codes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+   __m256 alpha = _mm256_permute_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(codes), _mm256_set1_ps(1.f / 255.f)), 0xFF);
+   __m256 color = _mm256_blend_ps(_mm256_i32gather_ps(lut, codes, 4), _mm256_set1_ps(1.f), 0x88);
+   return _mm256_mul_ps(color, alpha);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BE_CONCUR_TARGET("avx2")
+void linearize_downsample_row_avx2(const U8* r0, const U8* r1, F32* dest, U32 dest_width, const F32* lut) {
+   const __m128 quarter = _mm_set1_ps(0.25f);
+   for (std::size_t x = 0; x < dest_width; ++x) {
+      const std::size_t i = x * 8;
+      __m256 sum = _mm256_add_ps(linearize_pixel_pair_avx2(r0 + i, lut), linearize_pixel_pair_avx2(r1 + i, lut));
+      __m128 total = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+      _mm_storeu_ps(dest + x * 4, _mm_mul_ps(total, quarter));
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Two destination pixels per register: the rows are summed first, then the
+// 128-bit lanes are regrouped so that horizontally adjacent pixels line up.
+BE_CONCUR_TARGET("avx2")
+void downsample_row_avx2(const F32* r0, const F32* r1, F32* dest, U32 dest_width) {
+   const __m256 quarter = _mm256_set1_ps(0.25f);
+   std::size_t x = 0;
+   for (; x + 2 <= dest_width; x += 2) {
+      const std::size_t i = x * 8;
+      __m256 a = _mm256_add_ps(_mm256_loadu_ps(r0 + i), _mm256_loadu_ps(r1 + i));
+      __m256 b = _mm256_add_ps(_mm256_loadu_ps(r0 + i + 8), _mm256_loadu_ps(r1 + i + 8));
+      __m256 sum = _mm256_add_ps(_mm256_permute2f128_ps(a, b, 0x20), _mm256_permute2f128_ps(a, b, 0x31));
+      _mm256_storeu_ps(dest + x * 4, _mm256_mul_ps(sum, quarter));
+   }
+   if (x < dest_width) {
+      const std::size_t i = x * 8;
+      __m128 left = _mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r1 + i));
+      __m128 right = _mm_add_ps(_mm_loadu_ps(r0 + i + 4), _mm_loadu_ps(r1 + i + 4));
+      _mm_storeu_ps(dest + x * 4, _mm_mul_ps(_mm_add_ps(left, right), _mm256_castps256_ps128(quarter)));
+   }
+}
+#endif
+
+using linearize_pixels_func = void(*)(const U8*, F32*, std::size_t, const F32*);
+using linearize_downsample_row_func = void(*)(const U8*, const U8*, F32*, U32, const F32*);
+using downsample_row_func = void(*)(const F32*, const F32*, F32*, U32);
+
+///////////////////////////////////////////////////////////////////////////////
+linearize_pixels_func find_linearize_pixels_func() {
+#ifdef BE_CONCUR_RESAMPLE_SSE2
+   return linearize_pixels_sse2;
+#else
+   return linearize_pixels_generic;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+linearize_downsample_row_func find_linearize_downsample_row_func() {
+#ifdef BE_CONCUR_RESAMPLE_X86
+   if (has_avx2()) {
+      return linearize_downsample_row_avx2;
+   }
+#endif
+#ifdef BE_CONCUR_RESAMPLE_SSE2
+   return linearize_downsample_row_sse2;
+#else
+   return linearize_downsample_row_generic;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+downsample_row_func find_downsample_row_func() {
+#ifdef BE_CONCUR_RESAMPLE_X86
+   if (has_avx2()) {
+      return downsample_row_avx2;
+   }
+#endif
+#ifdef BE_CONCUR_RESAMPLE_SSE2
+   return downsample_row_sse2;
+#else
+   return downsample_row_generic;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Both dimensions of src must be even.
+LinearImage linearize_downsample_2x(const Image& src) {
+   static const linearize_downsample_row_func linearize_downsample_row = find_linearize_downsample_row_func();
+   const F32* lut = srgb_to_linear_lut();
+
+   LinearImage dest;
+   dest.width = src.width / 2;
+   dest.height = src.height / 2;
+   dest.pixels.resize(std::size_t(dest.width) * dest.height * 4);
+
+   const std::size_t src_stride = std::size_t(src.width) * 4;
+   const std::size_t dest_stride = std::size_t(dest.width) * 4;
+   for (U32 y = 0; y < dest.height; ++y) {
+      const U8* r0 = src.pixels.data() + std::size_t(y) * 2 * src_stride;
+      linearize_downsample_row(r0, r0 + src_stride, dest.pixels.data() + y * dest_stride, dest.width, lut);
+   }
+   return dest;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Both dimensions of src must be even.
+LinearImage downsample_2x(const LinearImage& src) {
+   static const downsample_row_func downsample_row = find_downsample_row_func();
+
+   LinearImage dest;
+   dest.width = src.width / 2;
+   dest.height = src.height / 2;
+   dest.pixels.resize(std::size_t(dest.width) * dest.height * 4);
+
+   const std::size_t src_stride = std::size_t(src.width) * 4;
+   const std::size_t dest_stride = std::size_t(dest.width) * 4;
+   for (U32 y = 0; y < dest.height; ++y) {
+      const F32* r0 = src.pixels.data() + std::size_t(y) * 2 * src_stride;
+      downsample_row(r0, r0 + src_stride, dest.pixels.data() + y * dest_stride, dest.width);
+   }
+   return dest;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool can_halve(U32 width, U32 height, U32 min_width, U32 min_height) {
+   return width % 2 == 0 && height % 2 == 0 &&
+      width / 2 >= U64(min_width) * 2 && height / 2 >= U64(min_height) * 2;
+}
+
+} // be::concur::()
+
+///////////////////////////////////////////////////////////////////////////////
+const char* resample_filter_name(ResampleFilter filter) {
+   switch (filter) {
+      case ResampleFilter::box:      return "box";
+      case ResampleFilter::mitchell: return "mitchell";
+      case ResampleFilter::lanczos3: return "lanczos3";
+      default:                       return "?";
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool parse_resample_filter(const S& name, ResampleFilter& filter) {
+   const ResampleFilter filters[] = { ResampleFilter::box, ResampleFilter::mitchell, ResampleFilter::lanczos3 };
+   for (ResampleFilter f : filters) {
+      if (name == resample_filter_name(f)) {
+         filter = f;
+         return true;
+      }
+   }
+   return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+LinearImage linearize_image(const Image& image) {
+   static const linearize_pixels_func linearize_pixels = find_linearize_pixels_func();
+
+   LinearImage result;
+   result.width = image.width;
+   result.height = image.height;
+   result.pixels.resize(image.pixels.size());
+   linearize_pixels(image.pixels.data(), result.pixels.data(), image.pixels.size() / 4, srgb_to_linear_lut());
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Image encode_srgb_image(const LinearImage& image) {
+   const F32* thresholds = linear_to_srgb_thresholds();
+   const U8* first_codes = linear_to_srgb_first_codes();
+
+   Image result;
+   result.width = image.width;
+   result.height = image.height;
+   result.pixels.resize(image.pixels.size());
+
+   const F32* src = image.pixels.data();
+   U8* dest = result.pixels.data();
+   for (std::size_t i = 0, n = image.pixels.size(); i < n; i += 4) {
+      F32 alpha = std::min(1.f, std::max(0.f, src[i + 3]));
+      U8 a = U8(alpha * 255.f + 0.5f);
+      if (a == 0) {
+         dest[i + 0] = dest[i + 1] = dest[i + 2] = dest[i + 3] = 0;
+         continue;
+      }
+
+      F32 scale = 1.f / alpha;
+      dest[i + 0] = linear_to_srgb(src[i + 0] * scale, thresholds, first_codes);
+      dest[i + 1] = linear_to_srgb(src[i + 1] * scale, thresholds, first_codes);
+      dest[i + 2] = linear_to_srgb(src[i + 2] * scale, thresholds, first_codes);
+      dest[i + 3] = a;
+   }
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+LinearImage resample_image(const LinearImage& src, U32 width, U32 height, ResampleFilter filter) {
+   static const horizontal_row_func horizontal_row = find_horizontal_row_func();
+   static const vertical_row_func vertical_row = find_vertical_row_func();
+
+   Weights cols = compute_weights(src.width, width, filter);
+   Weights rows = src.height == src.width && height == width ? cols : compute_weights(src.height, height, filter);
+
+   // Horizontal pass first, since icons are nearly always downscaled and
+   // that leaves fewer pixels for the vertical pass.
+   const std::size_t temp_stride = std::size_t(width) * 4;
+   std::vector<F32> temp(temp_stride * src.height);
+   for (U32 y = 0; y < src.height; ++y) {
+      horizontal_row(src.pixels.data() + std::size_t(y) * src.width * 4, temp.data() + y * temp_stride, width, cols);
+   }
+
+   LinearImage dest;
+   dest.width = width;
+   dest.height = height;
+   dest.pixels.resize(temp_stride * height);
+   for (U32 y = 0; y < height; ++y) {
+      vertical_row(temp.data() + rows.first[y] * temp_stride, temp_stride, dest.pixels.data() + y * temp_stride, temp_stride,
+                   rows.weights.data() + std::size_t(y) * rows.taps, rows.taps);
+   }
+
+   return dest;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+Image resample_image(const Image& src, U32 width, U32 height, ResampleFilter filter) {
+   return encode_srgb_image(resample_image(linearize_image(src), width, height, filter));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ResamplePyramid build_resample_pyramid(const Image& source, U32 min_width, U32 min_height, U32 max_width, U32 max_height) {
+   ResamplePyramid pyramid;
+   if (can_halve(source.width, source.height, min_width, min_height) &&
+       can_halve(source.width, source.height, max_width, max_height)) {
+      pyramid.levels.push_back(linearize_downsample_2x(source));
+   } else {
+      pyramid.levels.push_back(linearize_image(source));
+   }
+
+   while (can_halve(pyramid.levels.back().width, pyramid.levels.back().height, min_width, min_height)) {
+      pyramid.levels.push_back(downsample_2x(pyramid.levels.back()));
+   }
+   return pyramid;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const LinearImage& nearest_pyramid_level(const ResamplePyramid& pyramid, U32 width, U32 height) {
+   const LinearImage* result = &pyramid.levels.front();
+   for (const LinearImage& level : pyramid.levels) {
+      if (level.width >= U64(width) * 2 && level.height >= U64(height) * 2) {
+         result = &level;
+      }
+   }
+   return *result;
+}
+
+} // be::concur
+} // be
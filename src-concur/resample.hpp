@@ -0,0 +1,69 @@
+#pragma once
+#ifndef BE_CONCUR_RESAMPLE_HPP_
+#define BE_CONCUR_RESAMPLE_HPP_
+
+#include "image.hpp"
+
+namespace be {
+namespace concur {
+
+///////////////////////////////////////////////////////////////////////////////
+enum class ResampleFilter : U8 {
+   box,
+   mitchell,
+   lanczos3
+};
+
+const char* resample_filter_name(ResampleFilter filter);
+bool parse_resample_filter(const S& name, ResampleFilter& filter);
+
+///////////////////////////////////////////////////////////////////////////////
+// RGBA32F pixels in linear light with premultiplied alpha, top row first,
+// with no padding between rows.
+struct LinearImage {
+   U32 width = 0;
+   U32 height = 0;
+   std::vector<F32> pixels;
+};
+
+// Decodes sRGB color and premultiplies alpha.
+LinearImage linearize_image(const Image& image);
+
+// Unpremultiplies alpha and encodes color as sRGB, rounding to nearest.
+Image encode_srgb_image(const LinearImage& image);
+
+///////////////////////////////////////////////////////////////////////////////
+// Scales an image to the given size with separable horizontal and vertical
+// passes.  Filter weights are computed once per axis, and the passes use
+// AVX2 or SSE2 when available.  The aspect ratio is not preserved.
+LinearImage resample_image(const LinearImage& src, U32 width, U32 height, ResampleFilter filter);
+
+// Convenience wrapper which linearizes src and encodes the result as sRGB.
+Image resample_image(const Image& src, U32 width, U32 height, ResampleFilter filter);
+
+///////////////////////////////////////////////////////////////////////////////
+// Successive 2x box reductions of one linearized source, so that several
+// output sizes can each be finished with a single resample from a nearby
+// level rather than from the full resolution source.  Levels are ordered
+// from largest to smallest.
+struct ResamplePyramid {
+   std::vector<LinearImage> levels;
+};
+
+// Linearizes the source and halves it while both dimensions are even and the
+// next level is still at least twice min_width x min_height, so that the
+// final resample always reduces by at least 2x and the high-quality filter
+// still dominates.  When max_width x max_height can also be produced from
+// the first reduction, the full resolution source is not kept; the first
+// reduction is then done while linearizing, so the source is never stored as
+// floats.
+ResamplePyramid build_resample_pyramid(const Image& source, U32 min_width, U32 min_height, U32 max_width, U32 max_height);
+
+// Returns the smallest level which is at least twice the requested size in
+// both dimensions, or the largest level if there is none.
+const LinearImage& nearest_pyramid_level(const ResamplePyramid& pyramid, U32 width, U32 height);
+
+} // be::concur
+} // be
+
+#endif
@@ -0,0 +1,103 @@
+#include "source_cache.hpp"
+#include <be/util/get_file_contents.hpp>
+#include <stb/stb_image.h>
+#include <algorithm>
+
+namespace be {
+namespace concur {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+bool is_png(const S& contents) {
+   static const char signature[] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1A', '\n' };
+   return contents.size() >= sizeof(signature) && std::equal(signature, signature + sizeof(signature), contents.begin());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool decode_image(const S& contents, Image& image) {
+   int width, height, components;
+   stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(contents.data()), (int)contents.size(), &width, &height, &components, 4);
+   if (!pixels) {
+      return false;
+   }
+
+   image.width = U32(width);
+   image.height = U32(height);
+   image.pixels.assign(pixels, pixels + std::size_t(width) * height * 4);
+   stbi_image_free(pixels);
+   return true;
+}
+
+} // be::concur::()
+
+///////////////////////////////////////////////////////////////////////////////
+DecodedSource decode_source(const Path& path) {
+   S contents = util::get_file_contents(path);
+   DecodedSource source;
+   if (decode_image(contents, source.image)) {
+      source.png = is_png(contents);
+   }
+   return source;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void SourceCache::expect(const Path& path) {
+   // Jobs don't read paths which aren't regular files, so there's nothing to
+   // count for them.
+   std::error_code ec;
+   if (!fs::is_regular_file(path, ec)) {
+      return;
+   }
+   Path key = fs::canonical(path, ec);
+   if (ec) {
+      return;
+   }
+
+   std::lock_guard<std::mutex> lock(mutex_);
+   ++sources_[key].remaining_gets;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::shared_ptr<const DecodedSource> SourceCache::get(const Path& path) {
+   Path key = fs::canonical(path);
+
+   std::promise<std::shared_ptr<const DecodedSource>> promise;
+   std::shared_future<std::shared_ptr<const DecodedSource>> future;
+   bool owner = false;
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = sources_.find(key);
+      if (it == sources_.end()) {
+         // Not expected; no other job will ask for it.
+         owner = true;
+      } else {
+         Entry& entry = it->second;
+         if (!entry.source.valid()) {
+            entry.source = promise.get_future().share();
+            owner = true;
+         }
+         future = entry.source;
+
+         // The last expected job drops the entry; it and any jobs still
+         // waiting hold their own references to the result.
+         if (--entry.remaining_gets == 0) {
+            sources_.erase(it);
+         }
+      }
+   }
+
+   if (owner && !future.valid()) {
+      return std::make_shared<const DecodedSource>(decode_source(path));
+   } else if (owner) {
+      try {
+         promise.set_value(std::make_shared<const DecodedSource>(decode_source(path)));
+      } catch (...) {
+         promise.set_exception(std::current_exception());
+      }
+   }
+
+   return future.get();
+}
+
+} // be::concur
+} // be
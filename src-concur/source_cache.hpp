@@ -0,0 +1,51 @@
+#pragma once
+#ifndef BE_CONCUR_SOURCE_CACHE_HPP_
+#define BE_CONCUR_SOURCE_CACHE_HPP_
+
+#include "image.hpp"
+#include <be/core/filesystem.hpp>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace be {
+namespace concur {
+
+///////////////////////////////////////////////////////////////////////////////
+struct DecodedSource {
+   bool png = false;
+   Image image; // empty if the file's format was not recognized
+};
+
+// Reads and decodes an input file.  Throws if the file can't be read.
+DecodedSource decode_source(const Path& path);
+
+///////////////////////////////////////////////////////////////////////////////
+// Decodes each input file at most once for all of the jobs in a --batch run.
+// If several jobs request the same file at once, the first decodes it and
+// the others wait for the result.  Files are identified by canonical path.
+//
+// Each job that will read a file must be announced with expect() before any
+// job runs.  An entry is dropped as soon as its last expected get() has
+// fetched it, so decoded images live only as long as some job still needs
+// them.  Files which were never expected are decoded but not cached.
+class SourceCache final {
+public:
+   void expect(const Path& path);
+   std::shared_ptr<const DecodedSource> get(const Path& path);
+
+private:
+   struct Entry {
+      std::size_t remaining_gets = 0;
+      std::shared_future<std::shared_ptr<const DecodedSource>> source; // invalid until the first get()
+   };
+
+   std::mutex mutex_;
+   std::map<Path, Entry> sources_;
+};
+
+} // be::concur
+} // be
+
+#endif